@@ -31,11 +31,14 @@
 #ifndef AptoCoreRandom_h
 #define AptoCoreRandom_h
 
+#include "apto/core/Array.h"
+#include "apto/core/Set.h"
 #include "apto/platform/Visibility.h"
 
 #include <cassert>
 #include <limits>
 #include <cmath>
+#include <stdint.h>
 
 
 namespace Apto {
@@ -52,6 +55,7 @@ namespace Apto {
     
   private:
     unsigned int m_ubound;
+    double m_range;
     int m_max_seed;
     
     int m_orig_seed;
@@ -59,10 +63,22 @@ namespace Apto {
     double m_factor;
     
     double m_rand_norm_exprv;
+    int m_normal_method;
+    int m_discrete_method;
+    
+  public:
+    // Normal deviates are drawn by the ziggurat method or by the original exponential rejection method. Generators
+    // with a restricted range default to rejection, reproducing their prior results.
+    enum NormalMethod { NORMAL_REJECTION, NORMAL_ZIGGURAT };
+    
+    // Binomial and Poisson deviates are drawn exactly (BTPE and PTRS, with inversion for small means) or with the
+    // original normal and Poisson approximations. Generators with a restricted range default to the approximations.
+    enum DiscreteMethod { DISCRETE_APPROXIMATE, DISCRETE_EXACT };
     
   public:
     LIB_EXPORT virtual ~Random() = 0;
     
+    // Exclusive upper bound of the underlying generator, zero when it produces the full 32-bit range
     inline unsigned int UpperBound() const { return m_ubound; }
     inline int MaxSeed() const { return m_max_seed; }
 
@@ -72,36 +88,99 @@ namespace Apto {
 
     inline void ResetSeed(int new_seed);
     
+    // Independent streams, reproducibly seeded from the current seed and the stream ID. Generators that do not
+    // support streams return NULL from CreateStream.
+    LIB_EXPORT int StreamSeed(int stream_id) const;
+    LIB_EXPORT virtual Random* CreateStream(int stream_id) const;
+    
+    // Checkpointing. The state is StateSize() bytes in a fixed little endian layout: the engine's four character tag,
+    // the seeds, the normal and discrete methods, the cached exponential deviate, then the engine's own state.
+    // StateSize() is zero for generators that do not support checkpointing, and restoring fails unless the state was
+    // saved by the same engine type.
+    LIB_EXPORT int StateSize() const;
+    LIB_EXPORT bool SaveState(unsigned char* buffer, int size) const;
+    LIB_EXPORT bool RestoreState(const unsigned char* buffer, int size);
+    
     inline double GetDouble() { return getNext() * m_factor; }
     inline double GetDouble(double max) { return GetDouble() * max; }
     inline double GetDouble(double min, double max) { return GetDouble() * (max - min) + min; }
     
-    inline unsigned int GetUInt() { return static_cast<unsigned int>(std::numeric_limits<int>::max()); }
-    inline unsigned int GetUInt(unsigned int max) { return static_cast<unsigned int>(GetDouble(max)); }
-    inline unsigned int GetUInt(unsigned int min, unsigned int max) { return static_cast<unsigned int>(GetDouble(min, max)); }
+    // Uniform over the full 32-bit range. Engines with a smaller range combine two draws.
+    inline unsigned int GetUInt() { return (m_ubound == FULL_RANGE) ? getNext() : getCombinedUInt(); }
+    
+    // Unbiased draw in [0, max) using integer multiply-shift with rejection
+    inline unsigned int GetBoundedUInt(unsigned int max) { UIntSource source(*this); return boundedUInt(source, max); }
+    
+    // Range draws use GetBoundedUInt on full range engines. Others keep scaling GetDouble(), reproducing prior results.
+    inline unsigned int GetUInt(unsigned int max)
+    {
+      return (m_ubound == FULL_RANGE) ? GetBoundedUInt(max) : static_cast<unsigned int>(GetDouble(max));
+    }
+    inline unsigned int GetUInt(unsigned int min, unsigned int max)
+    {
+      return (m_ubound == FULL_RANGE) ? min + GetBoundedUInt(max - min) : static_cast<unsigned int>(GetDouble(min, max));
+    }
     
     inline unsigned int operator()(unsigned int max) { return GetUInt(max); }
     
-    inline int GetInt() { return static_cast<int>(GetDouble(std::numeric_limits<int>::min(), std::numeric_limits<int>::max())); }
-    inline int GetInt(int max) { return static_cast<int>(GetDouble(max)); }
-    inline int GetInt(int min, int max) { return static_cast<int>(floor(GetDouble(min, max))); }
+    inline int GetInt() { return static_cast<int>(GetUInt()); }
+    inline int GetInt(int max)
+    {
+      return (m_ubound == FULL_RANGE) ? static_cast<int>(GetBoundedUInt(max)) : static_cast<int>(GetDouble(max));
+    }
+    inline int GetInt(int min, int max)
+    {
+      if (m_ubound != FULL_RANGE) return static_cast<int>(floor(GetDouble(min, max)));
+      unsigned int span = static_cast<unsigned int>(max) - static_cast<unsigned int>(min);
+      return static_cast<int>(static_cast<unsigned int>(min) + GetBoundedUInt(span));
+    }
     
-    inline bool P(double p) { return (getNext() < (p * m_ubound)); }
+    inline bool P(double p) { return (getNext() < (p * m_range)); }
+    
+    // Bulk generation, each equivalent to count successive calls to GetDouble(), GetUInt(max) and P(p) respectively
+    LIB_EXPORT virtual void FillDouble(double* values, int count);
+    LIB_EXPORT virtual void FillUInt(unsigned int* values, int count, unsigned int max);
+    LIB_EXPORT virtual void FillBernoulli(bool* values, int count, double p);
+    
+    inline NormalMethod GetNormalMethod() const { return static_cast<NormalMethod>(m_normal_method); }
+    inline void SetNormalMethod(NormalMethod method) { m_normal_method = method; }
     
     LIB_EXPORT double GetRandNormal();
     inline double GetRandNormal(double mean, double variance) { return mean + GetRandNormal() * sqrt(variance); }
     
+    LIB_EXPORT double GetRandExponential();
+    inline double GetRandExponential(double mean) { return mean * GetRandExponential(); }
+    
+    inline DiscreteMethod GetDiscreteMethod() const { return static_cast<DiscreteMethod>(m_discrete_method); }
+    inline void SetDiscreteMethod(DiscreteMethod method) { m_discrete_method = method; }
+    
     LIB_EXPORT unsigned int GetRandPoisson(double mean);
     inline unsigned int GetRandPoisson(double n, double p);
     
     inline unsigned int GetFullRandBinomial(double n, double p);
     LIB_EXPORT unsigned int GetRandBinomial(double n, double p);
     
+    // Fills out_array with distinct indices in [0, num_in), in random order. Dense requests use a partial
+    // Fisher-Yates shuffle, sparse ones reject duplicates (by scan when few, by set membership when many).
     template <class A> void Choose(int num_in, A& out_array);
+    
+    // Reservoir sampling of out_array.GetSize() items from an iterator of unknown length (Next() / Get() protocol).
+    // Returns the number of items seen; when fewer than requested, only that many leading entries are filled.
+    template <class A, class I> int ChooseStream(I& it, A& out_array);
   
     
   protected:
-    inline Random(unsigned int ubound, int max_seed) : m_ubound(ubound), m_max_seed(max_seed), m_factor(1.0 / ubound) { ; }
+    static const unsigned int FULL_RANGE = 0;
+    
+    // Choose() switches to a partial shuffle once num_out * ratio reaches num_in, and to set based dedupe above the
+    // scan limit
+    static const int CHOOSE_DENSE_RATIO = 4;
+    static const int CHOOSE_SCAN_LIMIT = 32;
+    
+    inline Random(unsigned int ubound, int max_seed)
+      : m_ubound(ubound), m_range(ubound ? ubound : 4294967296.0), m_max_seed(max_seed), m_factor(1.0 / m_range)
+      , m_normal_method(ubound ? NORMAL_REJECTION : NORMAL_ZIGGURAT)
+      , m_discrete_method(ubound ? DISCRETE_APPROXIMATE : DISCRETE_EXACT) { ; }
   
   protected:
     // Internal implementation should reset based on current random seed
@@ -111,6 +190,56 @@ namespace Apto {
     LIB_EXPORT virtual unsigned int getNext() = 0;
     
     LIB_EXPORT virtual int getRandomSeed();
+    
+    // Engine checkpoint support, a non-zero tag identifies the engine's state layout
+    LIB_EXPORT virtual unsigned int stateTag() const;
+    LIB_EXPORT virtual int engineStateSize() const;
+    LIB_EXPORT virtual void saveEngineState(unsigned char* buffer) const;
+    LIB_EXPORT virtual void restoreEngineState(const unsigned char* buffer);
+    
+    static inline unsigned char* writeState(unsigned char* buffer, uint32_t value)
+    {
+      for (int i = 0; i < 4; i++) buffer[i] = static_cast<unsigned char>(value >> (8 * i));
+      return buffer + 4;
+    }
+    static inline unsigned char* writeState(unsigned char* buffer, uint64_t value)
+    {
+      for (int i = 0; i < 8; i++) buffer[i] = static_cast<unsigned char>(value >> (8 * i));
+      return buffer + 8;
+    }
+    static inline const unsigned char* readState(const unsigned char* buffer, uint32_t& value)
+    {
+      value = 0;
+      for (int i = 0; i < 4; i++) value |= static_cast<uint32_t>(buffer[i]) << (8 * i);
+      return buffer + 4;
+    }
+    static inline const unsigned char* readState(const unsigned char* buffer, uint64_t& value)
+    {
+      value = 0;
+      for (int i = 0; i < 8; i++) value |= static_cast<uint64_t>(buffer[i]) << (8 * i);
+      return buffer + 8;
+    }
+    
+    // Uniform 32-bit value assembled from two draws, for engines that do not produce the full range
+    LIB_EXPORT unsigned int getCombinedUInt();
+    
+    LIB_EXPORT double getZigguratNormal();
+    
+    // Lemire's multiply-shift bounded draw, where source.next() yields uniform 32-bit values
+    template <class S> static inline unsigned int boundedUInt(S& source, unsigned int max);
+    
+    // Bulk generation loops for engine implementations, drawing through the engine's non-virtual next()
+    template <class E> inline void fillDouble(E& engine, double* values, int count);
+    template <class E> inline void fillUInt(E& engine, unsigned int* values, int count, unsigned int max);
+    template <class E> inline void fillBernoulli(E& engine, bool* values, int count, double p);
+    
+  private:
+    struct UIntSource
+    {
+      Random& rng;
+      inline UIntSource(Random& in_rng) : rng(in_rng) { ; }
+      inline unsigned int next() { return rng.GetUInt(); }
+    };
   };
   
   
@@ -144,34 +273,117 @@ namespace Apto {
   }
   
   
+  template <class S> inline unsigned int Random::boundedUInt(S& source, unsigned int max)
+  {
+    // The high word of value * max is in [0, max). Low words below (2^32 mod max) mark the over-represented results,
+    // which are rejected; the modulo is only needed when the low word is small enough to possibly fall in that band.
+    uint64_t product = static_cast<uint64_t>(source.next()) * max;
+    unsigned int low = static_cast<unsigned int>(product);
+    if (low < max) {
+      const unsigned int threshold = (0u - max) % max;
+      while (low < threshold) {
+        product = static_cast<uint64_t>(source.next()) * max;
+        low = static_cast<unsigned int>(product);
+      }
+    }
+    return static_cast<unsigned int>(product >> 32);
+  }
+  
+  
+  template <class E> inline void Random::fillDouble(E& engine, double* values, int count)
+  {
+    const double factor = m_factor;
+    for (int i = 0; i < count; i++) values[i] = engine.next() * factor;
+  }
+  
+  template <class E> inline void Random::fillUInt(E& engine, unsigned int* values, int count, unsigned int max)
+  {
+    if (m_ubound == FULL_RANGE) {
+      for (int i = 0; i < count; i++) values[i] = boundedUInt(engine, max);
+      return;
+    }
+    const double factor = m_factor;
+    for (int i = 0; i < count; i++) values[i] = static_cast<unsigned int>((engine.next() * factor) * max);
+  }
+  
+  template <class E> inline void Random::fillBernoulli(E& engine, bool* values, int count, double p)
+  {
+    const double threshold = p * m_range;
+    for (int i = 0; i < count; i++) values[i] = (engine.next() < threshold);
+  }
+  
+  
   template <class A>
   void Random::Choose(int num_in, A& out_array)
   {
-    assert(num_in > out_array.GetSize());
+    const int num_out = out_array.GetSize();
+    assert(num_in >= num_out);
     
-    if (num_in == out_array.GetSize()) {
-      for (int i = 0; i < out_array.GetSize(); i++) out_array[i] = i;
+    if (num_in == num_out) {
+      for (int i = 0; i < num_out; i++) out_array[i] = i;
       return;
     }
     
-    int choice_count = 0;
-    while (choice_count < out_array.GetSize()) {
-      int next = GetInt(num_in);
-      
-      bool ok = true;
-      for (int i = 0; i < choice_count; i++) {
-        if (out_array[i] == next) {
-          ok = false;
-          break;
+    if (num_out * CHOOSE_DENSE_RATIO >= num_in) {
+      // Dense, partial Fisher-Yates shuffle over the full index range
+      Array<int> indices(num_in);
+      for (int i = 0; i < num_in; i++) indices[i] = i;
+      for (int i = 0; i < num_out; i++) {
+        int j = i + GetInt(num_in - i);
+        int tmp = indices[j];
+        indices[j] = indices[i];
+        indices[i] = tmp;
+        out_array[i] = tmp;
+      }
+    } else if (num_out <= CHOOSE_SCAN_LIMIT) {
+      // Sparse and small, rejecting duplicates by a scan of the prior choices
+      int choice_count = 0;
+      while (choice_count < num_out) {
+        int next = GetInt(num_in);
+        
+        bool ok = true;
+        for (int i = 0; i < choice_count; i++) {
+          if (out_array[i] == next) {
+            ok = false;
+            break;
+          }
+        }
+        
+        if (ok) {
+          out_array[choice_count] = next;
+          choice_count++;
         }
       }
-      
-      if (ok) {
+    } else {
+      // Sparse and large, rejecting duplicates by set membership
+      Set<int> chosen;
+      int choice_count = 0;
+      while (choice_count < num_out) {
+        int next = GetInt(num_in);
+        if (chosen.Has(next)) continue;
+        chosen.Insert(next);
         out_array[choice_count] = next;
         choice_count++;
       }
     }
   }
+  
+  template <class A, class I>
+  int Random::ChooseStream(I& it, A& out_array)
+  {
+    const int num_out = out_array.GetSize();
+    int num_seen = 0;
+    while (it.Next()) {
+      if (num_seen < num_out) {
+        out_array[num_seen] = *it.Get();
+      } else {
+        unsigned int j = GetUInt(static_cast<unsigned int>(num_seen) + 1);
+        if (j < static_cast<unsigned int>(num_out)) out_array[j] = *it.Get();
+      }
+      num_seen++;
+    }
+    return num_seen;
+  }
 
 };
 
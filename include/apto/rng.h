@@ -32,5 +32,10 @@
 #define AptoRNG_h
 
 #include "apto/rng/AvidaRNG.h"
+#include "apto/rng/AvidaRNGLanes.h"
+#include "apto/rng/PCG64.h"
+#include "apto/rng/Philox.h"
+#include "apto/rng/SplitMix64.h"
+#include "apto/rng/Xoshiro256StarStar.h"
 
 #endif
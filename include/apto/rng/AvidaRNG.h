@@ -41,6 +41,8 @@ namespace Apto {
     
     class AvidaRNG : public Random
     {
+      friend class Random;
+      friend class AvidaRNGLanes;
     private:
       LIB_EXPORT static const unsigned int UPPER_BOUND;
       LIB_EXPORT static const int MAX_SEED;
@@ -53,9 +55,26 @@ namespace Apto {
       LIB_EXPORT inline AvidaRNG(int seed = -1) : Random(UPPER_BOUND, MAX_SEED), m_inext(0), m_inextp(0) { ResetSeed(seed); }
       LIB_EXPORT ~AvidaRNG();
       
+      LIB_EXPORT Random* CreateStream(int stream_id) const;
+      
+      LIB_EXPORT void FillDouble(double* values, int count);
+      LIB_EXPORT void FillUInt(unsigned int* values, int count, unsigned int max);
+      LIB_EXPORT void FillBernoulli(bool* values, int count, double p);
+      
     protected:
       LIB_EXPORT void reset();
       LIB_EXPORT unsigned int getNext();
+      
+      LIB_EXPORT unsigned int stateTag() const;
+      LIB_EXPORT int engineStateSize() const;
+      LIB_EXPORT void saveEngineState(unsigned char* buffer) const;
+      LIB_EXPORT void restoreEngineState(const unsigned char* buffer);
+      
+    private:
+      inline unsigned int next();
+      
+      // Initialize a 56 word generator state from the supplied seed
+      static void initState(int seed, int* ma);
     };
     
   };
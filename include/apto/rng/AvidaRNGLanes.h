@@ -0,0 +1,103 @@
+/*
+ *  AvidaRNGLanes.h
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#ifndef AptoRNGAvidaRNGLanes_h
+#define AptoRNGAvidaRNGLanes_h
+
+#include "apto/core/Random.h"
+#include "apto/rng/AvidaRNG.h"
+
+namespace Apto {
+  namespace RNG {
+    
+    // AvidaRNGLanes - runs several AvidaRNG generators in lockstep, one per SIMD lane
+    // --------------------------------------------------------------------------------------------------------------
+    //
+    // Every lane is an independent AvidaRNG seeded with LaneSeed(lane), and the raw values of each lane match those of
+    // a scalar AvidaRNG reset with the same seed. As a Random, the lanes are consumed row by row: the first value of
+    // every lane, then the second value of every lane, and so on.
+    
+    class AvidaRNGLanes : public Random
+    {
+      friend class Random;
+    public:
+      static const int LANES = 8;
+      
+    private:
+      int m_inext;
+      int m_inextp;
+      int m_ma[56 * LANES];  // state word i of lane l is stored at [i * LANES + l]
+      
+      unsigned int m_row[LANES];  // current row, consumed one value at a time through the Random interface
+      int m_row_pos;
+      
+    public:
+      LIB_EXPORT inline AvidaRNGLanes(int seed = -1)
+        : Random(AvidaRNG::UPPER_BOUND, AvidaRNG::MAX_SEED), m_inext(0), m_inextp(0), m_row_pos(LANES) { ResetSeed(seed); }
+      LIB_EXPORT ~AvidaRNGLanes();
+      
+      LIB_EXPORT Random* CreateStream(int stream_id) const;
+      
+      inline int LaneSeed(int lane) const { return StreamSeed(lane); }
+      
+      // Raw output, rows * LANES values with lane l of each row at [row * LANES + l]. Output begins with the row after
+      // the one currently being consumed through the Random interface.
+      LIB_EXPORT void FillLanes(unsigned int* values, int rows);
+      
+      LIB_EXPORT void FillDouble(double* values, int count);
+      LIB_EXPORT void FillUInt(unsigned int* values, int count, unsigned int max);
+      LIB_EXPORT void FillBernoulli(bool* values, int count, double p);
+      
+    protected:
+      LIB_EXPORT void reset();
+      LIB_EXPORT unsigned int getNext();
+      
+      LIB_EXPORT unsigned int stateTag() const;
+      LIB_EXPORT int engineStateSize() const;
+      LIB_EXPORT void saveEngineState(unsigned char* buffer) const;
+      LIB_EXPORT void restoreEngineState(const unsigned char* buffer);
+      
+    private:
+      inline unsigned int next()
+      {
+        if (m_row_pos == LANES) {
+          step(m_row);
+          m_row_pos = 0;
+        }
+        return m_row[m_row_pos++];
+      }
+      
+      void step(unsigned int* row);
+    };
+    
+  };
+};
+
+#endif
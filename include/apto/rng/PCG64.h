@@ -0,0 +1,140 @@
+/*
+ *  PCG64.h
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#ifndef AptoRNGPCG64_h
+#define AptoRNGPCG64_h
+
+#include "apto/core/Random.h"
+
+#include <stdint.h>
+
+namespace Apto {
+  namespace RNG {
+    
+    // PCG64 - O'Neill's permuted congruential generator, 128-bit LCG state with XSL-RR 64-bit output
+    // --------------------------------------------------------------------------------------------------------------
+    
+    class PCG64 : public Random
+    {
+      friend class Random;
+    private:
+      LIB_EXPORT static const int MAX_SEED;
+      static const uint64_t MULTIPLIER_HI = 0x2360ED051FC65DA4ULL;
+      static const uint64_t MULTIPLIER_LO = 0x4385DF649FCCF645ULL;
+      static const uint64_t INCREMENT_HI = 0x5851F42D4C957F2DULL;
+      static const uint64_t INCREMENT_LO = 0x14057B7EF767814FULL;
+      
+      uint64_t m_state_hi;
+      uint64_t m_state_lo;
+      uint64_t m_stream_key;
+      
+    public:
+      LIB_EXPORT inline PCG64(int seed = -1)
+        : Random(FULL_RANGE, MAX_SEED), m_state_hi(0), m_state_lo(0), m_stream_key(0)
+      {
+        ResetSeed(seed);
+      }
+      LIB_EXPORT ~PCG64();
+      
+      // Stream k is k + 1 jumps past the state initialized from this generator's stream key (its seed, unless it is
+      // itself a stream), so streams created from a stream do not overlap that stream's siblings.
+      LIB_EXPORT Random* CreateStream(int stream_id) const;
+      
+      LIB_EXPORT void FillDouble(double* values, int count);
+      LIB_EXPORT void FillUInt(unsigned int* values, int count, unsigned int max);
+      LIB_EXPORT void FillBernoulli(bool* values, int count, double p);
+      
+      inline uint64_t GetUInt64() { return next64(); }
+      
+      // Skip ahead by the specified number of draws in O(log delta). Jump() advances 2^64 draws, LongJump() 2^96 draws.
+      inline void Advance(uint64_t delta) { advance(0, delta); }
+      inline void Jump() { advance(1, 0); }
+      inline void LongJump() { advance(static_cast<uint64_t>(1) << 32, 0); }
+      
+    protected:
+      LIB_EXPORT void reset();
+      LIB_EXPORT unsigned int getNext();
+      
+      LIB_EXPORT unsigned int stateTag() const;
+      LIB_EXPORT int engineStateSize() const;
+      LIB_EXPORT void saveEngineState(unsigned char* buffer) const;
+      LIB_EXPORT void restoreEngineState(const unsigned char* buffer);
+      
+    private:
+      static inline void mul128(uint64_t a_hi, uint64_t a_lo, uint64_t b_hi, uint64_t b_lo, uint64_t& hi, uint64_t& lo);
+      static inline void add128(uint64_t a_hi, uint64_t a_lo, uint64_t b_hi, uint64_t b_lo, uint64_t& hi, uint64_t& lo)
+      {
+        lo = a_lo + b_lo;
+        hi = a_hi + b_hi + ((lo < a_lo) ? 1 : 0);
+      }
+      
+      inline void step()
+      {
+        mul128(m_state_hi, m_state_lo, MULTIPLIER_HI, MULTIPLIER_LO, m_state_hi, m_state_lo);
+        add128(m_state_hi, m_state_lo, INCREMENT_HI, INCREMENT_LO, m_state_hi, m_state_lo);
+      }
+      inline uint64_t next64()
+      {
+        step();
+        const uint64_t xored = m_state_hi ^ m_state_lo;
+        const int rot = static_cast<int>(m_state_hi >> 58);
+        return (xored >> rot) | (xored << ((64 - rot) & 63));
+      }
+      inline unsigned int next() { return static_cast<unsigned int>(next64() >> 32); }
+      
+      void advance(uint64_t delta_hi, uint64_t delta_lo);
+      void initKey(uint64_t key);
+    };
+    
+    
+    inline void PCG64::mul128(uint64_t a_hi, uint64_t a_lo, uint64_t b_hi, uint64_t b_lo, uint64_t& hi, uint64_t& lo)
+    {
+#if defined(__SIZEOF_INT128__)
+      unsigned __int128 a = (static_cast<unsigned __int128>(a_hi) << 64) | a_lo;
+      unsigned __int128 b = (static_cast<unsigned __int128>(b_hi) << 64) | b_lo;
+      unsigned __int128 r = a * b;
+      hi = static_cast<uint64_t>(r >> 64);
+      lo = static_cast<uint64_t>(r);
+#else
+      // Full product of the low words from 32-bit pieces, the cross terms only contribute to the high word
+      const uint64_t a0 = a_lo & 0xFFFFFFFFULL, a1 = a_lo >> 32;
+      const uint64_t b0 = b_lo & 0xFFFFFFFFULL, b1 = b_lo >> 32;
+      const uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+      const uint64_t mid = (p00 >> 32) + (p01 & 0xFFFFFFFFULL) + (p10 & 0xFFFFFFFFULL);
+      const uint64_t cross = a_hi * b_lo + a_lo * b_hi;
+      lo = (mid << 32) | (p00 & 0xFFFFFFFFULL);
+      hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32) + cross;
+#endif
+    }
+    
+  };
+};
+
+#endif
@@ -0,0 +1,158 @@
+/*
+ *  Philox.h
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#ifndef AptoRNGPhilox_h
+#define AptoRNGPhilox_h
+
+#include "apto/core/Random.h"
+
+#include <stdint.h>
+
+namespace Apto {
+  namespace RNG {
+    
+    // Philox - Salmon et al.'s Philox4x32-10 counter based generator
+    // --------------------------------------------------------------------------------------------------------------
+    //
+    // Draw i of stream s is computed directly as a keyed bijection of the counter (i / 4, s), so any draw can be
+    // reproduced by any thread without shared state. The sequential Random interface walks the draws of one stream
+    // in order, starting at index 0, and Seek() moves it to any index. Parallel code can instead call Draw() or
+    // Fill() with the generator's Key() and a stream ID, e.g. one stream per organism and one index per use.
+    
+    class Philox : public Random
+    {
+      friend class Random;
+    private:
+      LIB_EXPORT static const int MAX_SEED;
+      static const uint32_t MULTIPLIER_0 = 0xD2511F53;
+      static const uint32_t MULTIPLIER_1 = 0xCD9E8D57;
+      static const uint32_t WEYL_0 = 0x9E3779B9;
+      static const uint32_t WEYL_1 = 0xBB67AE85;
+      static const int ROUNDS = 10;
+      
+      uint64_t m_key;
+      uint64_t m_stream;
+      uint64_t m_position;     // index of the next draw
+      uint64_t m_block_index;  // counter of the block held in m_block, never a valid block when invalidated
+      uint32_t m_block[4];
+      
+    public:
+      LIB_EXPORT inline Philox(int seed = -1, uint64_t stream = 0)
+        : Random(FULL_RANGE, MAX_SEED), m_key(0), m_stream(stream), m_position(0), m_block_index(~0ULL)
+      {
+        ResetSeed(seed);
+      }
+      LIB_EXPORT ~Philox();
+      
+      // Stream k of the same seed, identical to Philox(Seed(), k)
+      LIB_EXPORT Random* CreateStream(int stream_id) const;
+      
+      LIB_EXPORT void FillDouble(double* values, int count);
+      LIB_EXPORT void FillUInt(unsigned int* values, int count, unsigned int max);
+      LIB_EXPORT void FillBernoulli(bool* values, int count, double p);
+      
+      inline uint64_t Key() const { return m_key; }
+      inline uint64_t Stream() const { return m_stream; }
+      inline uint64_t Position() const { return m_position; }
+      inline void Seek(uint64_t position) { m_position = position; }
+      
+      inline unsigned int At(uint64_t index) const { return Draw(m_key, m_stream, index); }
+      inline uint64_t GetUInt64() { uint64_t hi = next(); return (hi << 32) | next(); }
+      
+      
+      // Random access, independent of any generator instance
+      LIB_EXPORT static uint64_t SeedKey(int seed);
+      
+      static inline unsigned int Draw(uint64_t key, uint64_t stream, uint64_t index)
+      {
+        uint32_t block[4];
+        Block(key, stream, index >> 2, block);
+        return block[index & 3];
+      }
+      static inline double DrawDouble(uint64_t key, uint64_t stream, uint64_t index)
+      {
+        return Draw(key, stream, index) * (1.0 / 4294967296.0);
+      }
+      
+      // Draws index through index + count - 1 of the stream
+      LIB_EXPORT static void Fill(uint64_t key, uint64_t stream, uint64_t index, unsigned int* values, int count);
+      
+      // The four 32-bit outputs for counter (block_index, stream), i.e. draws 4 * block_index through 4 * block_index + 3
+      static inline void Block(uint64_t key, uint64_t stream, uint64_t block_index, uint32_t* out)
+      {
+        uint32_t c0 = static_cast<uint32_t>(block_index);
+        uint32_t c1 = static_cast<uint32_t>(block_index >> 32);
+        uint32_t c2 = static_cast<uint32_t>(stream);
+        uint32_t c3 = static_cast<uint32_t>(stream >> 32);
+        uint32_t k0 = static_cast<uint32_t>(key);
+        uint32_t k1 = static_cast<uint32_t>(key >> 32);
+        
+        for (int r = 0; r < ROUNDS; r++) {
+          const uint64_t p0 = static_cast<uint64_t>(MULTIPLIER_0) * c0;
+          const uint64_t p1 = static_cast<uint64_t>(MULTIPLIER_1) * c2;
+          c0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+          c1 = static_cast<uint32_t>(p1);
+          c2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+          c3 = static_cast<uint32_t>(p0);
+          k0 += WEYL_0;
+          k1 += WEYL_1;
+        }
+        
+        out[0] = c0;
+        out[1] = c1;
+        out[2] = c2;
+        out[3] = c3;
+      }
+      
+    protected:
+      LIB_EXPORT void reset();
+      LIB_EXPORT unsigned int getNext();
+      
+      LIB_EXPORT unsigned int stateTag() const;
+      LIB_EXPORT int engineStateSize() const;
+      LIB_EXPORT void saveEngineState(unsigned char* buffer) const;
+      LIB_EXPORT void restoreEngineState(const unsigned char* buffer);
+      
+    private:
+      inline unsigned int next()
+      {
+        const uint64_t block_index = m_position >> 2;
+        if (block_index != m_block_index) {
+          Block(m_key, m_stream, block_index, m_block);
+          m_block_index = block_index;
+        }
+        return m_block[m_position++ & 3];
+      }
+    };
+    
+  };
+};
+
+#endif
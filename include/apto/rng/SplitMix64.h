@@ -0,0 +1,107 @@
+/*
+ *  SplitMix64.h
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#ifndef AptoRNGSplitMix64_h
+#define AptoRNGSplitMix64_h
+
+#include "apto/core/Random.h"
+
+#include <stdint.h>
+
+namespace Apto {
+  namespace RNG {
+    
+    // SplitMix64 - Steele, Lea and Flood's 64-bit counter based generator
+    // --------------------------------------------------------------------------------------------------------------
+    
+    class SplitMix64 : public Random
+    {
+      friend class Random;
+    private:
+      LIB_EXPORT static const int MAX_SEED;
+      static const uint64_t GOLDEN_GAMMA = 0x9E3779B97F4A7C15ULL;
+      
+      uint64_t m_state;
+      uint64_t m_stream_key;
+      
+    public:
+      LIB_EXPORT inline SplitMix64(int seed = -1) : Random(FULL_RANGE, MAX_SEED), m_state(0), m_stream_key(0)
+      {
+        ResetSeed(seed);
+      }
+      LIB_EXPORT ~SplitMix64();
+      
+      LIB_EXPORT Random* CreateStream(int stream_id) const;
+      
+      LIB_EXPORT void FillDouble(double* values, int count);
+      LIB_EXPORT void FillUInt(unsigned int* values, int count, unsigned int max);
+      LIB_EXPORT void FillBernoulli(bool* values, int count, double p);
+      
+      inline uint64_t GetUInt64() { return Next(m_state); }
+      
+      // Skip ahead by the specified number of 64-bit draws. Jump() advances 2^32 draws, LongJump() 2^48 draws.
+      inline void Advance(uint64_t delta) { m_state += delta * GOLDEN_GAMMA; }
+      inline void Jump() { Advance(static_cast<uint64_t>(1) << 32); }
+      inline void LongJump() { Advance(static_cast<uint64_t>(1) << 48); }
+      
+      // Advance a raw SplitMix64 state and return the next output. Also used to expand seeds for other engines.
+      static inline uint64_t Next(uint64_t& state)
+      {
+        uint64_t z = (state += GOLDEN_GAMMA);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+      }
+      
+      // Key of stream stream_id derived from a parent stream key. Engines key a seeded generator with its seed and
+      // each stream with this value, so that streams created from a stream are keyed apart from its siblings.
+      static inline uint64_t StreamKey(uint64_t key, int stream_id)
+      {
+        uint64_t state = ((key << 32) | (key >> 32)) ^ static_cast<unsigned int>(stream_id);
+        return Next(state);
+      }
+      
+    protected:
+      LIB_EXPORT void reset();
+      LIB_EXPORT unsigned int getNext();
+      
+      LIB_EXPORT unsigned int stateTag() const;
+      LIB_EXPORT int engineStateSize() const;
+      LIB_EXPORT void saveEngineState(unsigned char* buffer) const;
+      LIB_EXPORT void restoreEngineState(const unsigned char* buffer);
+      
+    private:
+      inline unsigned int next() { return static_cast<unsigned int>(Next(m_state) >> 32); }
+    };
+    
+  };
+};
+
+#endif
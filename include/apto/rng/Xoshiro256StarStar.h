@@ -0,0 +1,112 @@
+/*
+ *  Xoshiro256StarStar.h
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#ifndef AptoRNGXoshiro256StarStar_h
+#define AptoRNGXoshiro256StarStar_h
+
+#include "apto/core/Random.h"
+
+#include <stdint.h>
+
+namespace Apto {
+  namespace RNG {
+    
+    // Xoshiro256StarStar - Blackman and Vigna's xoshiro256** 64-bit generator, period 2^256 - 1
+    // --------------------------------------------------------------------------------------------------------------
+    
+    class Xoshiro256StarStar : public Random
+    {
+      friend class Random;
+    private:
+      LIB_EXPORT static const int MAX_SEED;
+      LIB_EXPORT static const uint64_t JUMP[4];
+      LIB_EXPORT static const uint64_t LONG_JUMP[4];
+      
+      uint64_t m_s[4];
+      uint64_t m_stream_key;
+      
+    public:
+      LIB_EXPORT inline Xoshiro256StarStar(int seed = -1) : Random(FULL_RANGE, MAX_SEED), m_stream_key(0)
+      {
+        ResetSeed(seed);
+      }
+      LIB_EXPORT ~Xoshiro256StarStar();
+      
+      // Stream k starts k + 1 jumps beyond the state expanded from this generator's stream key, which is the seed for
+      // a seeded generator. Streams of a stream are keyed apart from its siblings, so they start elsewhere.
+      LIB_EXPORT Random* CreateStream(int stream_id) const;
+      
+      LIB_EXPORT void FillDouble(double* values, int count);
+      LIB_EXPORT void FillUInt(unsigned int* values, int count, unsigned int max);
+      LIB_EXPORT void FillBernoulli(bool* values, int count, double p);
+      
+      inline uint64_t GetUInt64() { return next64(); }
+      
+      // Jump() advances 2^128 draws, LongJump() 2^192 draws
+      LIB_EXPORT void Jump();
+      LIB_EXPORT void LongJump();
+      
+    protected:
+      LIB_EXPORT void reset();
+      LIB_EXPORT unsigned int getNext();
+      
+      LIB_EXPORT unsigned int stateTag() const;
+      LIB_EXPORT int engineStateSize() const;
+      LIB_EXPORT void saveEngineState(unsigned char* buffer) const;
+      LIB_EXPORT void restoreEngineState(const unsigned char* buffer);
+      
+    private:
+      static inline uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+      
+      static inline uint64_t next64(uint64_t* s)
+      {
+        const uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+      }
+      inline uint64_t next64() { return next64(m_s); }
+      inline unsigned int next() { return static_cast<unsigned int>(next64() >> 32); }
+      
+      void jump(const uint64_t* polynomial) { jump(m_s, polynomial); }
+      static void jump(uint64_t* state, const uint64_t* polynomial);
+      
+      static void expandKey(uint64_t key, uint64_t* state);
+    };
+    
+  };
+};
+
+#endif
@@ -31,6 +31,7 @@
 #ifndef AptoScheduler_h
 #define AptoScheduler_h
 
+#include "apto/scheduler/Concurrent.h"
 #include "apto/scheduler/Integrated.h"
 #include "apto/scheduler/Probabilistic.h"
 #include "apto/scheduler/ProbabilisticIntegrated.h"
@@ -0,0 +1,174 @@
+/*
+ *  Concurrent.h
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#ifndef AptoSchedulerConcurrent_h
+#define AptoSchedulerConcurrent_h
+
+#include "apto/core/Array.h"
+#include "apto/core/Atomic.h"
+#include "apto/core/Functor.h"
+#include "apto/core/Mutex.h"
+#include "apto/core/Pair.h"
+#include "apto/core/PriorityScheduler.h"
+#include "apto/core/Random.h"
+#include "apto/core/SmartPtr.h"
+
+
+namespace Apto {
+  namespace Scheduler {
+    
+    // Concurrent - sharded scheduler front-end supporting simultaneous use by multiple worker threads
+    // --------------------------------------------------------------------------------------------------------------
+    //  Entries are partitioned across one sub-scheduler (shard) per worker. Each worker draws time slices only from
+    //  its own shard, so Next() requires no locking. Priority adjustments may be posted from any thread; they are
+    //  queued on the owning shard and applied by that shard's worker at the start of its next draw.
+    //
+    //  Since each worker executes slices from its own shard at roughly the same rate, shards should carry similar
+    //  total priority for time to be divided fairly. Rebalance() redistributes entries across shards and must be
+    //  called while no worker is active (i.e. between updates).
+    //
+    //  In deterministic mode each shard is given its own random number stream, created by the supplied generator's
+    //  CreateStream (which must be supported) from its seed and the shard ID, and all priority adjustments are
+    //  deferred until Synchronize() where they are applied in worker order. The schedule drawn by each worker is then
+    //  fully reproducible for a given number of workers, regardless of how the worker threads are interleaved.
+    //  Workers must post adjustments through their own Worker::AdjustPriority, as Concurrent::AdjustPriority may then
+    //  only be called while no worker is active.
+    
+    class Concurrent
+    {
+    public:
+      // Creates the sub-scheduler for a shard, given the shard entry count and shard id
+      typedef Functor<PriorityScheduler*, TL::Create<int, int> > ShardFactory;
+      
+      // Creates the sub-scheduler for a shard, given the shard entry count and the shard's random number stream
+      typedef Functor<PriorityScheduler*, TL::Create<int, SmartPtr<Random> > > StreamShardFactory;
+      
+      class Worker;
+      
+    private:
+      struct Shard;
+      
+    private:
+      int m_entry_count;
+      bool m_deterministic;
+      Array<Shard*> m_shards;
+      Array<Worker*> m_workers;
+      Array<int> m_entry_shard;   // Shard that currently owns each entry
+      Array<int> m_entry_local;   // Entry ID within the owning shard's sub-scheduler
+      Array<double> m_priority;   // Priority of each entry, as applied to its shard
+      
+      Array<Pair<int, double>, Smart> m_deferred;
+      
+      Concurrent();
+      Concurrent(const Concurrent&);
+      Concurrent& operator=(const Concurrent&);
+      
+    public:
+      LIB_EXPORT Concurrent(int entry_count, int num_workers, ShardFactory factory);
+      LIB_EXPORT Concurrent(int entry_count, int num_workers, SmartPtr<Random> rng, StreamShardFactory factory);
+      LIB_EXPORT ~Concurrent();
+      
+      LIB_EXPORT inline bool IsDeterministic() const { return m_deterministic; }
+      LIB_EXPORT inline int NumWorkers() const { return m_workers.GetSize(); }
+      LIB_EXPORT inline Worker& GetWorker(int worker_id) { return *m_workers[worker_id]; }
+      
+      // Safe to call from any thread, the adjustment takes effect on the owning shard's next draw. In deterministic
+      // mode it must only be called while no worker is active, the adjustment is deferred to the next Synchronize and
+      // applied after those posted by the workers.
+      LIB_EXPORT void AdjustPriority(int entry_id, double priority);
+      
+      LIB_EXPORT inline int EntryLimit() const { return m_entry_count; }
+      
+      // The following methods must only be called while no worker is active
+      LIB_EXPORT void Synchronize();
+      LIB_EXPORT bool Rebalance(double tolerance = 0.1);
+      LIB_EXPORT double ShardWeight(int shard_id) const;
+      
+    private:
+      void setupEntries();
+      int next(int shard_id);
+      void postAdjustment(int shard_id, int entry_id, double priority);
+      void processPending(Shard& shard);
+      void applyAdjustment(Shard& shard, int entry_id, double priority);
+      
+    private:
+      struct Shard
+      {
+        PriorityScheduler* scheduler;
+        Array<int> entries;                     // Global entry ID for each local entry (-1 if unassigned)
+        int active_count;                       // Number of entries with non-zero priority
+        double weight;                          // Sum of the priority of all entries
+        
+        Mutex pending_mutex;
+        Atomic::AtomicInt pending_count;
+        Array<Pair<int, double>, Smart> pending;
+        Array<Pair<int, double>, Smart> processing;
+        
+        inline Shard(PriorityScheduler* in_scheduler, int capacity)
+          : scheduler(in_scheduler), entries(capacity), active_count(0), weight(0.0), pending_count(0)
+        {
+          entries.SetAll(-1);
+        }
+        inline ~Shard() { delete scheduler; }
+      };
+      
+    public:
+      // Worker - PriorityScheduler view of the concurrent scheduler for a single worker thread
+      // ------------------------------------------------------------------------------------------------------------
+      //  Each worker must only be used by one thread at a time. Adjustments to entries owned by the worker's own
+      //  shard are applied immediately, all others are queued on the owning shard. In deterministic mode all
+      //  adjustments are held by the worker until the next Synchronize.
+      
+      class Worker : public PriorityScheduler
+      {
+        friend class Concurrent;
+      private:
+        Concurrent& m_sched;
+        int m_worker_id;
+        Array<Pair<int, double>, Smart> m_deferred;
+        
+        inline Worker(Concurrent& sched, int worker_id) : m_sched(sched), m_worker_id(worker_id) { ; }
+        
+      public:
+        LIB_EXPORT ~Worker();
+        
+        LIB_EXPORT inline int WorkerID() const { return m_worker_id; }
+        
+        LIB_EXPORT void AdjustPriority(int entry_id, double priority);
+        LIB_EXPORT int Next();
+        
+        LIB_EXPORT int EntryLimit() const;
+      };
+    };
+    
+  };
+};
+
+#endif
@@ -53,7 +53,12 @@ namespace Apto {
       Array<Node*> m_node_array;
       Array<double> m_node_weight;
       Array<double> m_priority_chart;
-      double m_total_weight;
+      
+      // Alias table over m_node_weight, rebuilt on the next draw whenever a node weight has changed
+      Array<double> m_alias_prob;
+      Array<int> m_alias;
+      Array<int> m_alias_work;
+      bool m_alias_dirty;
       
       
       ProbabilisticIntegrated();
@@ -66,6 +71,7 @@ namespace Apto {
       
       LIB_EXPORT void AdjustPriority(int entry_id, double priority);
       LIB_EXPORT int Next();
+      LIB_EXPORT void NextBatch(Array<int>& entry_ids);
 
       LIB_EXPORT int EntryLimit() const;
 
@@ -74,6 +80,9 @@ namespace Apto {
       void removeNode(int node_id);
       void resizeNodes(int new_size);
       
+      void rebuildAlias();
+      inline int drawEntry();
+      
     private:
       struct Node
       {
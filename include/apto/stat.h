@@ -33,6 +33,8 @@
 
 #include "apto/stat/Accumulator.h"
 #include "apto/stat/ContingencyTable.h"
+#include "apto/stat/ContingencyTableBuilder.h"
 #include "apto/stat/Functions.h"
+#include "apto/stat/LogFactorial.h"
 
 #endif
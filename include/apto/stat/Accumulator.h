@@ -61,11 +61,29 @@ namespace Apto {
                                                    AccumulatorStats::Internal::StatImpl>::SubClass SubClass;
       
     public:
+      static const std::size_t BATCH_BLOCK = 2048;  // values kept in cache across the passes of the stats
+      
       inline Accumulator() { Clear(); }
       
       inline void Clear() { this->SubClass::clear(); }
       
       void Add(T value) { this->SubClass::addValue(value); }
+      
+      // Adds n values at once. Each selected stat makes its own pass over every block of BATCH_BLOCK values, using
+      // several independent partial results so that the loops pipeline and vectorize. Floating point sums and moments
+      // may differ from adding the values one at a time in the last bits, as they are summed in a different order.
+      void AddBatch(const T* values, std::size_t n)
+      {
+        for (std::size_t offset = 0; offset < n; offset += BATCH_BLOCK) {
+          std::size_t count = n - offset;
+          if (count > BATCH_BLOCK) count = BATCH_BLOCK;
+          this->SubClass::addBatch(values + offset, count);
+        }
+      }
+      
+      // Combines the values of other into this accumulator, as though they had been added here, such as when reducing
+      // per-thread accumulators at the end of a parallel loop
+      void Merge(const Accumulator& other) { this->SubClass::merge(other); }
     };
     
   };
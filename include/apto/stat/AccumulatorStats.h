@@ -100,7 +100,10 @@ namespace Apto {
       // --------------------------------------------------------------------------------------------------------------
       
       namespace Internal {
-      
+        
+        // Independent partial results kept by the batch loops, wide enough to fill the vector units
+        static const int BATCH_LANES = 8;
+        
         template <class AccTypes>
         class StatImplRoot
         {
@@ -111,6 +114,8 @@ namespace Apto {
         protected:
           inline void clear() { ; }
           inline void addValue(ValueType value) { (void)value; }
+          inline void addBatch(const ValueType* values, std::size_t n) { (void)values; (void)n; }
+          inline void merge(const StatImplRoot& other) { (void)other; }
           
         public:
           inline void Moment() { ; }
@@ -140,6 +145,8 @@ namespace Apto {
         protected:
           inline void clear() { SubClass::clear(); m_n = 0; }
           inline void addValue(ValueType value) { SubClass::addValue(value); m_n++; }
+          inline void addBatch(const ValueType* values, std::size_t n) { SubClass::addBatch(values, n); m_n += n; }
+          inline void merge(const StatImpl& other) { SubClass::merge(other); m_n += other.m_n; }
           
         public:
           std::size_t Count() const { return m_n; }
@@ -161,8 +168,26 @@ namespace Apto {
           ValueType m_max;
           
         protected:
-          inline void clear() { SubClass::clear(); m_max = std::numeric_limits<ValueType>::min(); }
+          inline void clear() { SubClass::clear(); m_max = std::numeric_limits<ValueType>::lowest(); }
           inline void addValue(ValueType value) { SubClass::addValue(value); if (value > m_max) m_max = value; }
+          inline void addBatch(const ValueType* values, std::size_t n)
+          {
+            SubClass::addBatch(values, n);
+            ValueType m[BATCH_LANES];
+            for (int k = 0; k < BATCH_LANES; k++) m[k] = m_max;
+            const std::size_t lanes_end = n - (n % BATCH_LANES);
+            std::size_t i = 0;
+            for (; i < lanes_end; i += BATCH_LANES) {
+              for (int k = 0; k < BATCH_LANES; k++) m[k] = (values[i + k] > m[k]) ? values[i + k] : m[k];
+            }
+            for (; i < n; i++) m[0] = (values[i] > m[0]) ? values[i] : m[0];
+            for (int k = 0; k < BATCH_LANES; k++) if (m[k] > m_max) m_max = m[k];
+          }
+          inline void merge(const StatImpl& other)
+          {
+            SubClass::merge(other);
+            if (other.m_max > m_max) m_max = other.m_max;
+          }
           
         public:
           inline const ValueType& Max() const { return m_max; }
@@ -186,6 +211,24 @@ namespace Apto {
         protected:
           inline void clear() { SubClass::clear(); m_min = std::numeric_limits<ValueType>::max(); }
           inline void addValue(ValueType value) { SubClass::addValue(value); if (value < m_min) m_min = value; }
+          inline void addBatch(const ValueType* values, std::size_t n)
+          {
+            SubClass::addBatch(values, n);
+            ValueType m[BATCH_LANES];
+            for (int k = 0; k < BATCH_LANES; k++) m[k] = m_min;
+            const std::size_t lanes_end = n - (n % BATCH_LANES);
+            std::size_t i = 0;
+            for (; i < lanes_end; i += BATCH_LANES) {
+              for (int k = 0; k < BATCH_LANES; k++) m[k] = (values[i + k] < m[k]) ? values[i + k] : m[k];
+            }
+            for (; i < n; i++) m[0] = (values[i] < m[0]) ? values[i] : m[0];
+            for (int k = 0; k < BATCH_LANES; k++) if (m[k] < m_min) m_min = m[k];
+          }
+          inline void merge(const StatImpl& other)
+          {
+            SubClass::merge(other);
+            if (other.m_min < m_min) m_min = other.m_min;
+          }
           
         public:
           inline const ValueType& Min() const { return m_min; }
@@ -222,6 +265,20 @@ namespace Apto {
         protected:
           inline void clear() { SubClass::clear(); m_s = 0; }
           inline void addValue(ValueType value) { SubClass::addValue(value); m_s += pow(value, Type::Int<N>()); }
+          inline void addBatch(const ValueType* values, std::size_t n)
+          {
+            SubClass::addBatch(values, n);
+            ValueType s[BATCH_LANES];
+            for (int k = 0; k < BATCH_LANES; k++) s[k] = 0;
+            const std::size_t lanes_end = n - (n % BATCH_LANES);
+            std::size_t i = 0;
+            for (; i < lanes_end; i += BATCH_LANES) {
+              for (int k = 0; k < BATCH_LANES; k++) s[k] += pow(values[i + k], Type::Int<N>());
+            }
+            for (; i < n; i++) s[0] += pow(values[i], Type::Int<N>());
+            for (int k = 0; k < BATCH_LANES; k++) m_s += s[k];
+          }
+          inline void merge(const StatImpl& other) { SubClass::merge(other); m_s += other.m_s; }
           
         public:
           using SubClass::Moment;
@@ -246,6 +303,20 @@ namespace Apto {
         protected:
           inline void clear() { SubClass::clear(); m_s = 0; }
           inline void addValue(ValueType value) { SubClass::addValue(value); m_s += value; }
+          inline void addBatch(const ValueType* values, std::size_t n)
+          {
+            SubClass::addBatch(values, n);
+            ValueType s[BATCH_LANES];
+            for (int k = 0; k < BATCH_LANES; k++) s[k] = 0;
+            const std::size_t lanes_end = n - (n % BATCH_LANES);
+            std::size_t i = 0;
+            for (; i < lanes_end; i += BATCH_LANES) {
+              for (int k = 0; k < BATCH_LANES; k++) s[k] += values[i + k];
+            }
+            for (; i < n; i++) s[0] += values[i];
+            for (int k = 0; k < BATCH_LANES; k++) m_s += s[k];
+          }
+          inline void merge(const StatImpl& other) { SubClass::merge(other); m_s += other.m_s; }
           
         public:
           inline const ValueType& Sum() const { return m_s; }
@@ -272,6 +343,8 @@ namespace Apto {
         protected:
           inline void clear() { SubClass::clear(); }
           inline void addValue(ValueType value) { SubClass::addValue(value); }
+          inline void addBatch(const ValueType* values, std::size_t n) { SubClass::addBatch(values, n); }
+          inline void merge(const StatImpl& other) { SubClass::merge(other); }
           
         public:
           inline FloatType Mean() const
@@ -285,7 +358,8 @@ namespace Apto {
         // StatImpl<Variance>
         // --------------------------------------------------------------------------------------------------------------
         // 
-        //  Lazy calculation of sample variance based on the second moment, mean
+        //  Lazy calculation of sample variance based on the second moment, mean. Both are kept as raw sums, so merged
+        //  accumulators combine by addition and need no central moment correction.
         //
         
         template <class AccTypes, typename Base> class StatImpl<AccTypes, Variance, Base>
@@ -304,6 +378,8 @@ namespace Apto {
         protected:
           inline void clear() { SubClass::clear(); }
           inline void addValue(ValueType value) { SubClass::addValue(value); }
+          inline void addBatch(const ValueType* values, std::size_t n) { SubClass::addBatch(values, n); }
+          inline void merge(const StatImpl& other) { SubClass::merge(other); }
           
         public:
           inline FloatType Variance() const
@@ -333,6 +409,8 @@ namespace Apto {
         protected:
           inline void clear() { SubClass::clear(); }
           inline void addValue(ValueType value) { SubClass::addValue(value); }
+          inline void addBatch(const ValueType* values, std::size_t n) { SubClass::addBatch(values, n); }
+          inline void merge(const StatImpl& other) { SubClass::merge(other); }
           
         public:
           inline FloatType StdError() const { return sqrt(this->Variance() / (this->Count() - 1)); }
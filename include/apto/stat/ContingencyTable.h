@@ -39,8 +39,12 @@
 
 namespace Apto {
   namespace Stat {
+    template <class CellType> class ContingencyTableBuilder;
+    
     class ContingencyTable
     {
+      template <class CellType> friend class ContingencyTableBuilder;
+      
     protected:
       int m_nrow;
       int m_ncol;
@@ -53,9 +57,8 @@ namespace Apto {
       class ConstRowProxy;
       class ElementProxy;
       
-      ContingencyTable(); // @not_implemented
-      
     public:
+      inline ContingencyTable() : m_nrow(0), m_ncol(0), m_total(0) { ; }  // empty table, for use as an Array element
       LIB_EXPORT ContingencyTable(int nrow, int ncol);
       inline ContingencyTable(const ContingencyTable& rhs) { this->operator=(rhs); }
       
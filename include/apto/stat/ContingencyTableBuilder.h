@@ -0,0 +1,199 @@
+/*
+ *  ContingencyTableBuilder.h
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#ifndef AptoStatContingencyTableBuilder_h
+#define AptoStatContingencyTableBuilder_h
+
+#include "apto/core/Array.h"
+#include "apto/stat/ContingencyTable.h"
+
+#include <cassert>
+#include <limits>
+#include <stdint.h>
+
+
+namespace Apto {
+  namespace Stat {
+    
+    // ContingencyTableBuilder - counts streams of (row, col) observations into a dense table
+    // --------------------------------------------------------------------------------------------------------------
+    //
+    // Cells are held as CellType, so that uint16_t halves the footprint of tables whose cells stay small and int64_t
+    // or uint64_t count beyond the range of int. Row and column marginals and the total are kept up to date as
+    // observations arrive. Build writes the counts straight into a ContingencyTable, bypassing its per-element
+    // marginal updates, and requires every count to fit in an int.
+    
+    template <class CellType = int> class ContingencyTableBuilder
+    {
+    public:
+      static const int LANES = 4;      // independent partial counts, so repeated cells do not serialize the count
+      static const int CHUNK = 256;    // observations whose cell indices are computed together
+      static const int MAX_LANED_CELLS = 4096;
+      
+    private:
+      int m_nrow;
+      int m_ncol;
+      Array<CellType> m_cells;
+      Array<int64_t> m_row_marginals;
+      Array<int64_t> m_col_marginals;
+      int64_t m_total;
+      
+      Array<int> m_partials;  // LANES partial counts of every cell, for batches of small tables
+      
+    public:
+      ContingencyTableBuilder(int nrow, int ncol)
+        : m_nrow(nrow), m_ncol(ncol), m_cells(nrow * ncol), m_row_marginals(nrow), m_col_marginals(ncol)
+        , m_partials((nrow * ncol <= MAX_LANED_CELLS) ? LANES * nrow * ncol : 0)
+      {
+        assert(nrow > 0);
+        assert(ncol > 0);
+        Clear();
+      }
+      
+      int NumRows() const { return m_nrow; }
+      int NumCols() const { return m_ncol; }
+      
+      inline CellType Count(int row, int col) const { return m_cells[(row * m_ncol) + col]; }
+      inline int64_t RowMarginal(int row) const { return m_row_marginals[row]; }
+      inline int64_t ColMarginal(int col) const { return m_col_marginals[col]; }
+      inline int64_t Total() const { return m_total; }
+      
+      void Clear()
+      {
+        m_cells.SetAll(0);
+        m_row_marginals.SetAll(0);
+        m_col_marginals.SetAll(0);
+        m_total = 0;
+      }
+      
+      inline void Add(int row, int col)
+      {
+        assert(row >= 0 && row < m_nrow && col >= 0 && col < m_ncol);
+        CellType& cell = m_cells[(row * m_ncol) + col];
+        assert(cell < std::numeric_limits<CellType>::max());
+        cell++;
+        m_row_marginals[row]++;
+        m_col_marginals[col]++;
+        m_total++;
+      }
+      
+      // Adds count observations, the i-th falling in row rows[i] and column cols[i]
+      void Add(const int* rows, const int* cols, int count);
+      
+      // Writes the counts and marginals into table, resizing it to match
+      void Build(ContingencyTable& table) const;
+      inline ContingencyTable Build() const { ContingencyTable table; Build(table); return table; }
+      
+    private:
+      void addLaned(const int* rows, const int* cols, int count);
+    };
+    
+    
+    template <class CellType> void ContingencyTableBuilder<CellType>::Add(const int* rows, const int* cols, int count)
+    {
+      // Batches large enough to repay clearing the partial counts go through the lanes, others count directly
+      if (m_partials.GetSize() > 0 && count >= m_partials.GetSize()) {
+        addLaned(rows, cols, count);
+        return;
+      }
+      for (int i = 0; i < count; i++) Add(rows[i], cols[i]);
+    }
+    
+    
+    template <class CellType> void ContingencyTableBuilder<CellType>::addLaned(const int* rows, const int* cols,
+                                                                               int count)
+    {
+      const int ncells = m_cells.GetSize();
+      int* partials = &m_partials[0];
+      for (int i = 0; i < LANES * ncells; i++) partials[i] = 0;
+      
+      int cell_idx[CHUNK];
+      for (int base = 0; base < count; base += CHUNK) {
+        const int n = (count - base < CHUNK) ? count - base : CHUNK;
+        const int* chunk_rows = rows + base;
+        const int* chunk_cols = cols + base;
+        
+        // Cell indices of the whole chunk first, in a loop free of stores to the counts
+        for (int i = 0; i < n; i++) cell_idx[i] = chunk_rows[i] * m_ncol + chunk_cols[i];
+#ifndef NDEBUG
+        for (int i = 0; i < n; i++) {
+          assert(chunk_rows[i] >= 0 && chunk_rows[i] < m_nrow && chunk_cols[i] >= 0 && chunk_cols[i] < m_ncol);
+        }
+#endif
+        
+        // Consecutive observations count into different lanes, so runs of one cell do not wait on each other
+        int i = 0;
+        for (; i + LANES <= n; i += LANES) {
+          partials[cell_idx[i]]++;
+          partials[ncells + cell_idx[i + 1]]++;
+          partials[2 * ncells + cell_idx[i + 2]]++;
+          partials[3 * ncells + cell_idx[i + 3]]++;
+        }
+        for (; i < n; i++) partials[cell_idx[i]]++;
+      }
+      
+      // Fold the lanes into the cells, and the cells into the marginals
+      CellType* cells = &m_cells[0];
+      for (int r = 0; r < m_nrow; r++) {
+        int64_t row_count = 0;
+        for (int c = 0; c < m_ncol; c++) {
+          const int idx = r * m_ncol + c;
+          const int64_t cell_count =
+            (int64_t)partials[idx] + partials[ncells + idx] + partials[2 * ncells + idx] + partials[3 * ncells + idx];
+          assert((uint64_t)cell_count <= (uint64_t)(std::numeric_limits<CellType>::max() - cells[idx]));
+          cells[idx] = (CellType)(cells[idx] + cell_count);
+          m_col_marginals[c] += cell_count;
+          row_count += cell_count;
+        }
+        m_row_marginals[r] += row_count;
+      }
+      m_total += count;
+    }
+    
+    
+    template <class CellType> void ContingencyTableBuilder<CellType>::Build(ContingencyTable& table) const
+    {
+      assert(m_total <= std::numeric_limits<int>::max());
+      
+      table.m_nrow = m_nrow;
+      table.m_ncol = m_ncol;
+      table.m_table.ResizeClear(m_cells.GetSize());
+      table.m_row_marginals.ResizeClear(m_nrow);
+      table.m_col_marginals.ResizeClear(m_ncol);
+      for (int i = 0; i < m_cells.GetSize(); i++) table.m_table[i] = (int)m_cells[i];
+      for (int r = 0; r < m_nrow; r++) table.m_row_marginals[r] = (int)m_row_marginals[r];
+      for (int c = 0; c < m_ncol; c++) table.m_col_marginals[c] = (int)m_col_marginals[c];
+      table.m_total = (int)m_total;
+    }
+    
+  };
+};
+
+#endif
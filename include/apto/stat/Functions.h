@@ -31,14 +31,60 @@
 #ifndef AptoStatFunctions_h
 #define AptoStatFunctions_h
 
+#include "apto/core/Array.h"
 #include "apto/platform/Visibility.h"
 
 
 namespace Apto {
+  class Random;
+  
   namespace Stat {
     class ContingencyTable;
     
     LIB_EXPORT double FishersExact(const ContingencyTable& table);
+    
+    // Calculates the p-value of every table in the batch, in order. Small tables are distributed across a persistent
+    // pool of worker threads, large tables are calculated one at a time with the pool working within each table.
+    LIB_EXPORT void FishersExact(const Array<ContingencyTable>& tables, Array<double>& pvalues);
+    
+    // The FishersExact p-value of the 2 x 2 table {{n11, n12}, {n21, n22}}, summed directly from the hypergeometric
+    // distribution without allocating. FishersExact uses the same kernel for 2 x 2 tables.
+    LIB_EXPORT double FishersExact2x2(int n11, int n12, int n21, int n22);
+    
+    // Calculates the p-values of count 2 x 2 tables, whose cells are stored row-major and four to a table in cells.
+    LIB_EXPORT void FishersExact2x2(const int* cells, double* pvalues, int count);
+    
+    // The FishersExact p-value with tables exactly as probable as the observed table counted at half weight, summed
+    // in the same pass. The batch form distributes tables across the worker pool as the FishersExact batch does.
+    LIB_EXPORT double FishersExactMidP(const ContingencyTable& table);
+    LIB_EXPORT void FishersExactMidP(const Array<ContingencyTable>& tables, Array<double>& pvalues);
+    
+    // Pearson's chi-square and the likelihood-ratio (G) tests of independence, with expected counts taken from the
+    // table marginals. Rows and columns whose marginals are zero are left out of the degrees of freedom.
+    LIB_EXPORT double ChiSquareTest(const ContingencyTable& table);
+    LIB_EXPORT double GTest(const ContingencyTable& table);
+    
+    struct ContingencyTestResult
+    {
+      int df;
+      double chi_square;
+      double chi_square_pvalue;
+      double g;
+      double g_pvalue;
+      double mid_p;  // FishersExactMidP, NaN when the table was not selected for exact testing
+    };
+    
+    // Runs the chi-square and G-tests over every table in a single pass, then the FishersExactMidP batch over those
+    // tables where either p-value is at most exact_threshold. Empty tables have NaN results.
+    LIB_EXPORT void ContingencyTests(const Array<ContingencyTable>& tables, Array<ContingencyTestResult>& results,
+                                     double exact_threshold = 1.0);
+    
+    // Estimates the FishersExact p-value of the table from random tables sharing its marginals, in bounded time.
+    // Sampling runs on the worker pool, on streams created from rng, until the 95% confidence interval of the estimate
+    // is at most confidence_width wide or max_samples tables have been drawn. The standard error of the estimate is
+    // returned in std_error.
+    LIB_EXPORT double FishersExactMonteCarlo(const ContingencyTable& table, Random& rng, double& std_error,
+                                             double confidence_width = 0.001, int max_samples = 1000000);
   };
 };
 
@@ -30,10 +30,14 @@
 
 #include "apto/core/Random.h"
 
+#include "apto/core/Algorithms.h"
+
 #include "apto/platform.h"
 
+#include <cstring>
 #include <ctime>
 #include <limits>
+#include <stdint.h>
 #if APTO_PLATFORM(WINDOWS)
 # include <process.h>
 #else
@@ -45,11 +49,250 @@
 static const unsigned int BINOMIAL_TO_NORMAL = 50;    //if < n*p*(1-p)
 static const unsigned int BINOMIAL_TO_POISSON = 1000; //if < n
 
+// Exact Sampling, inversion is used below these means
+static const double BINOMIAL_INVERSION_LIMIT = 30.0;
+static const double POISSON_INVERSION_LIMIT = 10.0;
+
+
+// Ziggurat layers (Marsaglia and Tsang, 2000). Layer i > 0 covers [0, x[i]) horizontally and [f[i], f[i + 1])
+// vertically, each with area v. Layer 0 is the base strip of width v / f(r), standing in for the region below f(r)
+// including the tail beyond r = x[1].
+template <int N> struct ZigguratTable
+{
+  double x[N + 1];
+  double f[N + 1];
+  
+  ZigguratTable(double r, double v, double (*density)(double), double (*inverse)(double))
+  {
+    x[0] = v / density(r);
+    x[1] = r;
+    for (int i = 1; i < N - 1; i++) x[i + 1] = inverse(v / x[i] + density(x[i]));
+    x[N] = 0.0;
+    for (int i = 0; i <= N; i++) f[i] = density(x[i]);
+  }
+};
+
+static double NormalDensity(double x) { return exp(-0.5 * x * x); }
+static double NormalInverse(double y) { return sqrt(-2.0 * log(y)); }
+static double ExponentialDensity(double x) { return exp(-x); }
+static double ExponentialInverse(double y) { return -log(y); }
+
+static const ZigguratTable<128>& NormalZiggurat()
+{
+  static const ZigguratTable<128> table(3.442619855899, 9.91256303526217e-3, NormalDensity, NormalInverse);
+  return table;
+}
+
+static const ZigguratTable<256>& ExponentialZiggurat()
+{
+  static const ZigguratTable<256> table(7.69711747013104972, 3.949659822581572e-3, ExponentialDensity, ExponentialInverse);
+  return table;
+}
+
+// Layer selection uses the low bits of a 32-bit draw, the remaining high bits supply the position within the layer
+static const double LAYER_POSITION_SCALE = 1.0 / 16777216.0;
+
+
+// Exact discrete samplers
+// --------------------------------------------------------------------------------------------------------------
+
+// Sequential search of the binomial CDF, for p <= 0.5 and small n * p. Restarts if round-off runs past the bound.
+static unsigned int BinomialInversion(Apto::Random& rng, unsigned int n, double p)
+{
+  const double q = 1.0 - p;
+  const double qn = exp(n * log(q));
+  const double np = n * p;
+  const double bound = Apto::Min(static_cast<double>(n), np + 10.0 * sqrt(np * q + 1.0));
+  
+  unsigned int x = 0;
+  double px = qn;
+  double u = rng.GetDouble();
+  while (u > px) {
+    x++;
+    if (x > bound) {
+      x = 0;
+      px = qn;
+      u = rng.GetDouble();
+    } else {
+      u -= px;
+      px = ((n - x + 1) * p * px) / (x * q);
+    }
+  }
+  return x;
+}
+
+// Kachitvichyanukul and Schmeiser's BTPE (triangle, parallelogram, exponential) rejection sampler, for p <= 0.5
+static unsigned int BinomialBTPE(Apto::Random& rng, unsigned int n, double p)
+{
+  const double q = 1.0 - p;
+  const double nrq = n * p * q;
+  const double fm = n * p + p;
+  const int m = static_cast<int>(floor(fm));
+  const double p1 = floor(2.195 * sqrt(nrq) - 4.6 * q) + 0.5;
+  const double xm = m + 0.5;
+  const double xl = xm - p1;
+  const double xr = xm + p1;
+  const double c = 0.134 + 20.5 / (15.3 + m);
+  double a = (fm - xl) / (fm - xl * p);
+  const double laml = a * (1.0 + a / 2.0);
+  a = (xr - fm) / (xr * q);
+  const double lamr = a * (1.0 + a / 2.0);
+  const double p2 = p1 * (1.0 + 2.0 * c);
+  const double p3 = p2 + c / laml;
+  const double p4 = p3 + c / lamr;
+  
+  while (true) {
+    double u = rng.GetDouble() * p4;
+    double v = rng.GetDouble();
+    int y;
+    
+    if (u <= p1) {
+      // Triangular region, accepted immediately
+      return static_cast<unsigned int>(floor(xm - p1 * v + u));
+    } else if (u <= p2) {
+      // Parallelograms
+      double x = xl + (u - p1) / c;
+      v = v * c + 1.0 - fabs(m - x + 0.5) / p1;
+      if (v > 1.0) continue;
+      y = static_cast<int>(floor(x));
+    } else if (u <= p3) {
+      // Left exponential tail
+      if (v == 0.0) continue;
+      double x = floor(xl + log(v) / laml);
+      if (x < 0.0) continue;
+      y = static_cast<int>(x);
+      v = v * (u - p2) * laml;
+    } else {
+      // Right exponential tail
+      if (v == 0.0) continue;
+      double x = floor(xr - log(v) / lamr);
+      if (x > n) continue;
+      y = static_cast<int>(x);
+      v = v * (u - p3) * lamr;
+    }
+    
+    int k = (y > m) ? (y - m) : (m - y);
+    if (k <= 20 || k >= nrq / 2.0 - 1.0) {
+      // Explicit evaluation of f(y) / f(m) by recursion
+      const double s = p / q;
+      const double as = s * (n + 1);
+      double f = 1.0;
+      if (m < y) {
+        for (int i = m + 1; i <= y; i++) f *= (as / i - s);
+      } else if (m > y) {
+        for (int i = y + 1; i <= m; i++) f /= (as / i - s);
+      }
+      if (v <= f) return y;
+      continue;
+    }
+    
+    // Squeeze using upper and lower bounds on log(f(y))
+    const double rho = (k / nrq) * ((k * (k / 3.0 + 0.625) + 1.0 / 6.0) / nrq + 0.5);
+    const double t = -static_cast<double>(k) * k / (2.0 * nrq);
+    const double log_v = log(v);
+    if (log_v < t - rho) return y;
+    if (log_v > t + rho) continue;
+    
+    // Final acceptance test against Stirling's approximation
+    const double x1 = y + 1;
+    const double f1 = m + 1;
+    const double z = n + 1.0 - m;
+    const double w = n - y + 1.0;
+    const double x2 = x1 * x1;
+    const double f2 = f1 * f1;
+    const double z2 = z * z;
+    const double w2 = w * w;
+    const double bound = xm * log(f1 / x1) + (n - m + 0.5) * log(z / w) + (y - m) * log(w * p / (x1 * q))
+      + (13860.0 - (462.0 - (132.0 - (99.0 - 140.0 / f2) / f2) / f2) / f2) / f1 / 166320.0
+      + (13860.0 - (462.0 - (132.0 - (99.0 - 140.0 / z2) / z2) / z2) / z2) / z / 166320.0
+      + (13860.0 - (462.0 - (132.0 - (99.0 - 140.0 / x2) / x2) / x2) / x2) / x1 / 166320.0
+      + (13860.0 - (462.0 - (132.0 - (99.0 - 140.0 / w2) / w2) / w2) / w2) / w / 166320.0;
+    if (log_v <= bound) return y;
+  }
+}
+
+// Sequential search of the Poisson CDF, for small means
+static unsigned int PoissonInversion(Apto::Random& rng, double mean)
+{
+  unsigned int k = 0;
+  double pk = exp(-mean);
+  double cdf = pk;
+  double u = rng.GetDouble();
+  while (u > cdf) {
+    k++;
+    pk *= mean / k;
+    double next_cdf = cdf + pk;
+    if (next_cdf == cdf) break;  // remaining mass is below round-off
+    cdf = next_cdf;
+  }
+  return k;
+}
+
+// Hormann's PTRS (transformed rejection with squeeze), for means of 10 or more
+static unsigned int PoissonPTRS(Apto::Random& rng, double mean)
+{
+  const double slam = sqrt(mean);
+  const double loglam = log(mean);
+  const double b = 0.931 + 2.53 * slam;
+  const double a = -0.059 + 0.02483 * b;
+  const double log_invalpha = log(1.1239 + 1.1328 / (b - 3.4));
+  const double vr = 0.9277 - 3.6224 / (b - 2.0);
+  
+  while (true) {
+    double u = rng.GetDouble() - 0.5;
+    double v = rng.GetDouble();
+    double us = 0.5 - fabs(u);
+    double k = floor((2.0 * a / us + b) * u + mean + 0.43);
+    if (us >= 0.07 && v <= vr) return static_cast<unsigned int>(k);
+    if (k < 0.0 || (us < 0.013 && v > us)) continue;
+    if (log(v) + log_invalpha - log(a / (us * us) + b) <= -mean + k * loglam - lgamma(k + 1.0)) {
+      return static_cast<unsigned int>(k);
+    }
+  }
+}
+
+
 Apto::Random::~Random() { ; }
 
 
+int Apto::Random::StreamSeed(int stream_id) const
+{
+  // Combine the seed and stream ID, then scramble with the SplitMix64 finalizer so that neighboring streams are
+  // seeded with unrelated values
+  uint64_t z = (static_cast<uint64_t>(static_cast<unsigned int>(m_seed)) << 32) | static_cast<unsigned int>(stream_id);
+  z += 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z = z ^ (z >> 31);
+  return static_cast<int>(z % static_cast<uint64_t>(m_max_seed));
+}
+
+Apto::Random* Apto::Random::CreateStream(int) const
+{
+  return NULL;
+}
+
+
+void Apto::Random::FillDouble(double* values, int count)
+{
+  for (int i = 0; i < count; i++) values[i] = GetDouble();
+}
+
+void Apto::Random::FillUInt(unsigned int* values, int count, unsigned int max)
+{
+  for (int i = 0; i < count; i++) values[i] = GetUInt(max);
+}
+
+void Apto::Random::FillBernoulli(bool* values, int count, double p)
+{
+  for (int i = 0; i < count; i++) values[i] = P(p);
+}
+
+
 double Apto::Random::GetRandNormal()
 {
+  if (m_normal_method == NORMAL_ZIGGURAT) return getZigguratNormal();
+  
   // Draw from a Unit Normal Dist, using rejection method and saving initial exponential random variable
   double expRV2;
   while (1) {
@@ -65,8 +308,31 @@ double Apto::Random::GetRandNormal()
 }
 
 
+double Apto::Random::GetRandExponential()
+{
+  // Draw from a Unit Exponential Dist, using the ziggurat method
+  const ZigguratTable<256>& zt = ExponentialZiggurat();
+  while (true) {
+    unsigned int bits = GetUInt();
+    int layer = bits & 0xFF;
+    double x = ((bits >> 8) + 0.5) * LAYER_POSITION_SCALE * zt.x[layer];
+    if (x < zt.x[layer + 1]) return x;
+    
+    // The exponential tail is memoryless, so beyond r it is simply a shifted exponential
+    if (layer == 0) return zt.x[1] - log(1.0 - GetDouble());
+    
+    if (zt.f[layer] + GetDouble() * (zt.f[layer + 1] - zt.f[layer]) < ExponentialDensity(x)) return x;
+  }
+}
+
+
 unsigned int Apto::Random::GetRandPoisson(const double mean)
 {
+  if (m_discrete_method == DISCRETE_EXACT) {
+    if (mean <= 0.0) return 0;
+    return (mean < POISSON_INVERSION_LIMIT) ? PoissonInversion(*this, mean) : PoissonPTRS(*this, mean);
+  }
+  
   // Draw from a Poisson Dist with mean, if cannot calculate, returns max
   // Uses Rejection Method
   unsigned int k = 0;
@@ -82,6 +348,17 @@ unsigned int Apto::Random::GetRandPoisson(const double mean)
 
 unsigned int Apto::Random::GetRandBinomial(const double n, const double p)
 {
+  if (m_discrete_method == DISCRETE_EXACT) {
+    unsigned int trials = static_cast<unsigned int>(n);
+    if (trials == 0 || p <= 0.0) return 0;
+    if (p >= 1.0) return trials;
+    
+    // Both samplers require p <= 0.5, the complement is taken for larger p
+    double r = (p > 0.5) ? 1.0 - p : p;
+    unsigned int k = (trials * r < BINOMIAL_INVERSION_LIMIT) ? BinomialInversion(*this, trials, r) : BinomialBTPE(*this, trials, r);
+    return (p > 0.5) ? trials - k : k;
+  }
+  
   // Approximate Binomial if appropriate
   if (n * p * (1 - p) >= BINOMIAL_TO_NORMAL) {
     // if np(1-p) is large, use a Normal approx
@@ -100,6 +377,113 @@ unsigned int Apto::Random::GetRandBinomial(const double n, const double p)
 }
 
 
+// Tag, original seed, seed, normal method, discrete method and the cached exponential deviate
+static const int BASE_STATE_SIZE = 4 + 4 + 4 + 4 + 4 + 8;
+
+int Apto::Random::StateSize() const
+{
+  return (stateTag()) ? BASE_STATE_SIZE + engineStateSize() : 0;
+}
+
+bool Apto::Random::SaveState(unsigned char* buffer, int size) const
+{
+  if (!stateTag() || size < StateSize()) return false;
+  
+  uint64_t exprv_bits;
+  memcpy(&exprv_bits, &m_rand_norm_exprv, sizeof(exprv_bits));
+  
+  buffer = writeState(buffer, static_cast<uint32_t>(stateTag()));
+  buffer = writeState(buffer, static_cast<uint32_t>(m_orig_seed));
+  buffer = writeState(buffer, static_cast<uint32_t>(m_seed));
+  buffer = writeState(buffer, static_cast<uint32_t>(m_normal_method));
+  buffer = writeState(buffer, static_cast<uint32_t>(m_discrete_method));
+  buffer = writeState(buffer, exprv_bits);
+  saveEngineState(buffer);
+  return true;
+}
+
+bool Apto::Random::RestoreState(const unsigned char* buffer, int size)
+{
+  if (!stateTag() || size < StateSize()) return false;
+  
+  uint32_t tag;
+  buffer = readState(buffer, tag);
+  if (tag != stateTag()) return false;
+  
+  uint32_t orig_seed, seed, normal_method, discrete_method;
+  uint64_t exprv_bits;
+  buffer = readState(buffer, orig_seed);
+  buffer = readState(buffer, seed);
+  buffer = readState(buffer, normal_method);
+  buffer = readState(buffer, discrete_method);
+  buffer = readState(buffer, exprv_bits);
+  
+  m_orig_seed = static_cast<int>(orig_seed);
+  m_seed = static_cast<int>(seed);
+  m_normal_method = static_cast<int>(normal_method);
+  m_discrete_method = static_cast<int>(discrete_method);
+  memcpy(&m_rand_norm_exprv, &exprv_bits, sizeof(exprv_bits));
+  restoreEngineState(buffer);
+  return true;
+}
+
+
+unsigned int Apto::Random::stateTag() const
+{
+  return 0;
+}
+
+int Apto::Random::engineStateSize() const
+{
+  return 0;
+}
+
+void Apto::Random::saveEngineState(unsigned char*) const { ; }
+
+void Apto::Random::restoreEngineState(const unsigned char*) { ; }
+
+
+unsigned int Apto::Random::getCombinedUInt()
+{
+  // Two draws form a uniform value in [0, range^2). Rejecting the final partial block of 2^32 values leaves the low
+  // 32 bits uniform.
+  assert(m_ubound >= 65536);
+  const uint64_t range = m_ubound;
+  const uint64_t limit = ((range * range) >> 32) << 32;
+  while (true) {
+    uint64_t value = static_cast<uint64_t>(getNext()) * range;
+    value += getNext();
+    if (value < limit) return static_cast<unsigned int>(value);
+  }
+}
+
+
+double Apto::Random::getZigguratNormal()
+{
+  const ZigguratTable<128>& zt = NormalZiggurat();
+  while (true) {
+    // The top 25 bits, taken as a signed value, supply both the sign and the position within the layer
+    unsigned int bits = GetUInt();
+    int layer = bits & 0x7F;
+    double x = ((static_cast<int>(bits) >> 7) + 0.5) * LAYER_POSITION_SCALE * zt.x[layer];
+    if (fabs(x) < zt.x[layer + 1]) return x;
+    
+    if (layer == 0) {
+      // Marsaglia's tail method for values beyond r
+      const double r = zt.x[1];
+      double tail_x, tail_y;
+      do {
+        tail_x = -log(1.0 - GetDouble()) / r;
+        tail_y = -log(1.0 - GetDouble());
+      } while (2.0 * tail_y < tail_x * tail_x);
+      return (x < 0.0) ? -(r + tail_x) : (r + tail_x);
+    }
+    
+    if (zt.f[layer] + GetDouble() * (zt.f[layer + 1] - zt.f[layer]) < NormalDensity(x)) return x;
+  }
+}
+
+
 int Apto::Random::getRandomSeed()
 {
   int seed_time = static_cast<int>(time(NULL));
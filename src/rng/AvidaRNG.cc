@@ -37,41 +37,50 @@ const int Apto::RNG::AvidaRNG::MAX_SEED = 161803398;
 Apto::RNG::AvidaRNG::~AvidaRNG() { ; }
 
 
+Apto::Random* Apto::RNG::AvidaRNG::CreateStream(int stream_id) const
+{
+  return new AvidaRNG(StreamSeed(stream_id));
+}
+
+
 void Apto::RNG::AvidaRNG::reset()
+{
+  initState(Seed(), m_ma);
+  m_inext = 0;
+  m_inextp = 31;
+}
+
+
+void Apto::RNG::AvidaRNG::initState(int seed, int* ma)
 {
   int mj, mk;
   
   // Clear variables
-  m_inext = 0;
-  m_inextp = 0;
-  for (int i = 0; i < 56; i++) m_ma[i] = 0;
+  for (int i = 0; i < 56; i++) ma[i] = 0;
   
-  mj = MAX_SEED - Seed();
+  mj = MAX_SEED - seed;
   mj %= UPPER_BOUND;
-  m_ma[55] = mj;
+  ma[55] = mj;
   mk = 1;
   
   for (int i = 1; i < 55; i++) {
     int j = (21 * i) % 55;
-    m_ma[j] = mk;
+    ma[j] = mk;
     mk = mj - mk;
     if (mk < 0) mk += UPPER_BOUND;
-    mj = m_ma[j];
+    mj = ma[j];
   }
   
   for (int k = 0; k < 4; ++k) {
     for (int j = 1; j < 55; ++j) {
-      m_ma[j] -= m_ma[1 + (j + 30) % 55];
-      if (m_ma[j] < 0) m_ma[j] += UPPER_BOUND;
+      ma[j] -= ma[1 + (j + 30) % 55];
+      if (ma[j] < 0) ma[j] += UPPER_BOUND;
     }
   }
-  
-  m_inext = 0;
-  m_inextp = 31;
 }
 
 
-unsigned int Apto::RNG::AvidaRNG::getNext()
+inline unsigned int Apto::RNG::AvidaRNG::next()
 {
   if (++m_inext == 56) m_inext = 0;
   if (++m_inextp == 56) m_inextp = 0;
@@ -82,3 +91,58 @@ unsigned int Apto::RNG::AvidaRNG::getNext()
   m_ma[m_inext] = mj;
   return mj;
 }
+
+unsigned int Apto::RNG::AvidaRNG::getNext()
+{
+  return next();
+}
+
+
+// Checkpoint layout, tagged "AVRG"
+// --------------------------------------------------------------------------------------------------------------
+
+unsigned int Apto::RNG::AvidaRNG::stateTag() const
+{
+  return 0x47525641;
+}
+
+int Apto::RNG::AvidaRNG::engineStateSize() const
+{
+  return 4 * (2 + 56);
+}
+
+void Apto::RNG::AvidaRNG::saveEngineState(unsigned char* buffer) const
+{
+  buffer = writeState(buffer, static_cast<uint32_t>(m_inext));
+  buffer = writeState(buffer, static_cast<uint32_t>(m_inextp));
+  for (int i = 0; i < 56; i++) buffer = writeState(buffer, static_cast<uint32_t>(m_ma[i]));
+}
+
+void Apto::RNG::AvidaRNG::restoreEngineState(const unsigned char* buffer)
+{
+  uint32_t value;
+  buffer = readState(buffer, value);
+  m_inext = static_cast<int>(value);
+  buffer = readState(buffer, value);
+  m_inextp = static_cast<int>(value);
+  for (int i = 0; i < 56; i++) {
+    buffer = readState(buffer, value);
+    m_ma[i] = static_cast<int>(value);
+  }
+}
+
+
+void Apto::RNG::AvidaRNG::FillDouble(double* values, int count)
+{
+  fillDouble(*this, values, count);
+}
+
+void Apto::RNG::AvidaRNG::FillUInt(unsigned int* values, int count, unsigned int max)
+{
+  fillUInt(*this, values, count, max);
+}
+
+void Apto::RNG::AvidaRNG::FillBernoulli(bool* values, int count, double p)
+{
+  fillBernoulli(*this, values, count, p);
+}
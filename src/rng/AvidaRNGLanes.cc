@@ -0,0 +1,174 @@
+/*
+ *  AvidaRNGLanes.cc
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#include "apto/rng/AvidaRNGLanes.h"
+
+#include "apto/rng/AvidaRNG.h"
+
+#if defined(__AVX2__)
+# include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+# include <emmintrin.h>
+# define APTO_AVIDARNGLANES_SSE2 1
+#endif
+
+
+Apto::RNG::AvidaRNGLanes::~AvidaRNGLanes() { ; }
+
+
+Apto::Random* Apto::RNG::AvidaRNGLanes::CreateStream(int stream_id) const
+{
+  return new AvidaRNGLanes(StreamSeed(stream_id));
+}
+
+
+void Apto::RNG::AvidaRNGLanes::FillLanes(unsigned int* values, int rows)
+{
+  for (int r = 0; r < rows; r++) step(values + r * LANES);
+}
+
+
+void Apto::RNG::AvidaRNGLanes::FillDouble(double* values, int count)
+{
+  fillDouble(*this, values, count);
+}
+
+void Apto::RNG::AvidaRNGLanes::FillUInt(unsigned int* values, int count, unsigned int max)
+{
+  fillUInt(*this, values, count, max);
+}
+
+void Apto::RNG::AvidaRNGLanes::FillBernoulli(bool* values, int count, double p)
+{
+  fillBernoulli(*this, values, count, p);
+}
+
+
+void Apto::RNG::AvidaRNGLanes::reset()
+{
+  // Seed each lane exactly as a scalar AvidaRNG would be, then interleave the lane states
+  int lane_state[56];
+  for (int l = 0; l < LANES; l++) {
+    AvidaRNG::initState(LaneSeed(l), lane_state);
+    for (int i = 0; i < 56; i++) m_ma[i * LANES + l] = lane_state[i];
+  }
+  
+  m_inext = 0;
+  m_inextp = 31;
+  m_row_pos = LANES;
+}
+
+
+unsigned int Apto::RNG::AvidaRNGLanes::getNext()
+{
+  return next();
+}
+
+
+// Checkpoint layout, tagged "AVLN"
+// --------------------------------------------------------------------------------------------------------------
+
+unsigned int Apto::RNG::AvidaRNGLanes::stateTag() const
+{
+  return 0x4E4C5641;
+}
+
+int Apto::RNG::AvidaRNGLanes::engineStateSize() const
+{
+  return 4 * (2 + 56 * LANES + LANES + 1);
+}
+
+void Apto::RNG::AvidaRNGLanes::saveEngineState(unsigned char* buffer) const
+{
+  buffer = writeState(buffer, static_cast<uint32_t>(m_inext));
+  buffer = writeState(buffer, static_cast<uint32_t>(m_inextp));
+  for (int i = 0; i < 56 * LANES; i++) buffer = writeState(buffer, static_cast<uint32_t>(m_ma[i]));
+  for (int i = 0; i < LANES; i++) buffer = writeState(buffer, static_cast<uint32_t>(m_row[i]));
+  buffer = writeState(buffer, static_cast<uint32_t>(m_row_pos));
+}
+
+void Apto::RNG::AvidaRNGLanes::restoreEngineState(const unsigned char* buffer)
+{
+  uint32_t value;
+  buffer = readState(buffer, value);
+  m_inext = static_cast<int>(value);
+  buffer = readState(buffer, value);
+  m_inextp = static_cast<int>(value);
+  for (int i = 0; i < 56 * LANES; i++) {
+    buffer = readState(buffer, value);
+    m_ma[i] = static_cast<int>(value);
+  }
+  for (int i = 0; i < LANES; i++) {
+    buffer = readState(buffer, value);
+    m_row[i] = value;
+  }
+  buffer = readState(buffer, value);
+  m_row_pos = static_cast<int>(value);
+}
+
+
+void Apto::RNG::AvidaRNGLanes::step(unsigned int* row)
+{
+  // All lanes share the lag indices, so a step is an element-wise subtraction of two state rows, wrapped into
+  // [0, UPPER_BOUND) by adding UPPER_BOUND to negative differences
+  if (++m_inext == 56) m_inext = 0;
+  if (++m_inextp == 56) m_inextp = 0;
+  int* ma_next = m_ma + m_inext * LANES;
+  const int* ma_nextp = m_ma + m_inextp * LANES;
+  
+#if defined(__AVX2__)
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i ubound = _mm256_set1_epi32(static_cast<int>(AvidaRNG::UPPER_BOUND));
+  for (int l = 0; l < LANES; l += 8) {
+    __m256i mj = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ma_next + l)),
+                                  _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ma_nextp + l)));
+    mj = _mm256_add_epi32(mj, _mm256_and_si256(_mm256_cmpgt_epi32(zero, mj), ubound));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(ma_next + l), mj);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(row + l), mj);
+  }
+#elif defined(APTO_AVIDARNGLANES_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i ubound = _mm_set1_epi32(static_cast<int>(AvidaRNG::UPPER_BOUND));
+  for (int l = 0; l < LANES; l += 4) {
+    __m128i mj = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ma_next + l)),
+                               _mm_loadu_si128(reinterpret_cast<const __m128i*>(ma_nextp + l)));
+    mj = _mm_add_epi32(mj, _mm_and_si128(_mm_cmplt_epi32(mj, zero), ubound));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(ma_next + l), mj);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(row + l), mj);
+  }
+#else
+  for (int l = 0; l < LANES; l++) {
+    int mj = ma_next[l] - ma_nextp[l];
+    if (mj < 0) mj += AvidaRNG::UPPER_BOUND;
+    ma_next[l] = mj;
+    row[l] = mj;
+  }
+#endif
+}
@@ -0,0 +1,154 @@
+/*
+ *  PCG64.cc
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#include "apto/rng/PCG64.h"
+
+#include "apto/rng/SplitMix64.h"
+
+#include <limits>
+
+
+const int Apto::RNG::PCG64::MAX_SEED = std::numeric_limits<int>::max();
+
+Apto::RNG::PCG64::~PCG64() { ; }
+
+
+Apto::Random* Apto::RNG::PCG64::CreateStream(int stream_id) const
+{
+  // Streams start from the state of this generator's stream key, after the draw ResetSeed consumes, each one jump
+  // (2^64 draws) beyond the last
+  PCG64* stream = new PCG64(Seed());
+  stream->initKey(m_stream_key);
+  stream->step();
+  stream->advance(static_cast<uint64_t>(stream_id) + 1, 0);
+  stream->m_stream_key = SplitMix64::StreamKey(m_stream_key, stream_id);
+  return stream;
+}
+
+
+void Apto::RNG::PCG64::reset()
+{
+  m_stream_key = static_cast<uint64_t>(Seed());
+  initKey(m_stream_key);
+}
+
+
+void Apto::RNG::PCG64::initKey(uint64_t key)
+{
+  // Expand the key into a 128-bit initial state with SplitMix64, then initialize as pcg64_srandom_r does
+  uint64_t init_hi = SplitMix64::Next(key);
+  uint64_t init_lo = SplitMix64::Next(key);
+  
+  m_state_hi = 0;
+  m_state_lo = 0;
+  step();
+  add128(m_state_hi, m_state_lo, init_hi, init_lo, m_state_hi, m_state_lo);
+  step();
+}
+
+
+unsigned int Apto::RNG::PCG64::getNext()
+{
+  return next();
+}
+
+
+// Checkpoint layout, tagged "PC64"
+// --------------------------------------------------------------------------------------------------------------
+
+unsigned int Apto::RNG::PCG64::stateTag() const
+{
+  return 0x34364350;
+}
+
+int Apto::RNG::PCG64::engineStateSize() const
+{
+  return 3 * 8;
+}
+
+void Apto::RNG::PCG64::saveEngineState(unsigned char* buffer) const
+{
+  buffer = writeState(buffer, m_state_hi);
+  buffer = writeState(buffer, m_state_lo);
+  writeState(buffer, m_stream_key);
+}
+
+void Apto::RNG::PCG64::restoreEngineState(const unsigned char* buffer)
+{
+  buffer = readState(buffer, m_state_hi);
+  buffer = readState(buffer, m_state_lo);
+  readState(buffer, m_stream_key);
+}
+
+
+void Apto::RNG::PCG64::FillDouble(double* values, int count)
+{
+  fillDouble(*this, values, count);
+}
+
+void Apto::RNG::PCG64::FillUInt(unsigned int* values, int count, unsigned int max)
+{
+  fillUInt(*this, values, count, max);
+}
+
+void Apto::RNG::PCG64::FillBernoulli(bool* values, int count, double p)
+{
+  fillBernoulli(*this, values, count, p);
+}
+
+
+void Apto::RNG::PCG64::advance(uint64_t delta_hi, uint64_t delta_lo)
+{
+  // Brown's algorithm for LCG jump-ahead, composing the step function by repeated squaring
+  uint64_t acc_mult_hi = 0, acc_mult_lo = 1;
+  uint64_t acc_plus_hi = 0, acc_plus_lo = 0;
+  uint64_t cur_mult_hi = MULTIPLIER_HI, cur_mult_lo = MULTIPLIER_LO;
+  uint64_t cur_plus_hi = INCREMENT_HI, cur_plus_lo = INCREMENT_LO;
+  
+  while (delta_hi || delta_lo) {
+    if (delta_lo & 1) {
+      mul128(acc_mult_hi, acc_mult_lo, cur_mult_hi, cur_mult_lo, acc_mult_hi, acc_mult_lo);
+      mul128(acc_plus_hi, acc_plus_lo, cur_mult_hi, cur_mult_lo, acc_plus_hi, acc_plus_lo);
+      add128(acc_plus_hi, acc_plus_lo, cur_plus_hi, cur_plus_lo, acc_plus_hi, acc_plus_lo);
+    }
+    
+    // cur_plus = (cur_mult + 1) * cur_plus, cur_mult = cur_mult^2
+    uint64_t mult_inc_hi, mult_inc_lo;
+    add128(cur_mult_hi, cur_mult_lo, 0, 1, mult_inc_hi, mult_inc_lo);
+    mul128(mult_inc_hi, mult_inc_lo, cur_plus_hi, cur_plus_lo, cur_plus_hi, cur_plus_lo);
+    mul128(cur_mult_hi, cur_mult_lo, cur_mult_hi, cur_mult_lo, cur_mult_hi, cur_mult_lo);
+    
+    delta_lo = (delta_lo >> 1) | (delta_hi << 63);
+    delta_hi >>= 1;
+  }
+  
+  mul128(m_state_hi, m_state_lo, acc_mult_hi, acc_mult_lo, m_state_hi, m_state_lo);
+  add128(m_state_hi, m_state_lo, acc_plus_hi, acc_plus_lo, m_state_hi, m_state_lo);
+}
@@ -0,0 +1,135 @@
+/*
+ *  Philox.cc
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#include "apto/rng/Philox.h"
+
+#include "apto/rng/SplitMix64.h"
+
+#include <limits>
+
+
+const int Apto::RNG::Philox::MAX_SEED = std::numeric_limits<int>::max();
+
+Apto::RNG::Philox::~Philox() { ; }
+
+
+Apto::Random* Apto::RNG::Philox::CreateStream(int stream_id) const
+{
+  return new Philox(Seed(), static_cast<uint64_t>(stream_id));
+}
+
+
+uint64_t Apto::RNG::Philox::SeedKey(int seed)
+{
+  uint64_t seed_state = static_cast<uint64_t>(seed);
+  return SplitMix64::Next(seed_state);
+}
+
+
+void Apto::RNG::Philox::Fill(uint64_t key, uint64_t stream, uint64_t index, unsigned int* values, int count)
+{
+  uint32_t block[4];
+  int i = 0;
+  
+  // Leading partial block
+  if (index & 3) {
+    Block(key, stream, index >> 2, block);
+    for (int w = static_cast<int>(index & 3); w < 4 && i < count; w++) values[i++] = block[w];
+    index = (index | 3) + 1;
+  }
+  
+  // Whole blocks, then the trailing partial block
+  for (uint64_t block_index = index >> 2; i < count; block_index++) {
+    Block(key, stream, block_index, block);
+    for (int w = 0; w < 4 && i < count; w++) values[i++] = block[w];
+  }
+}
+
+
+void Apto::RNG::Philox::reset()
+{
+  m_key = SeedKey(Seed());
+  m_block_index = ~0ULL;
+  
+  // ResetSeed consumes one draw after reset. Position it at the final index of the stream, so that the consumed draw
+  // wraps around and the sequential interface begins at draw 0.
+  m_position = ~0ULL;
+}
+
+
+unsigned int Apto::RNG::Philox::getNext()
+{
+  return next();
+}
+
+
+// Checkpoint layout, tagged "PHLX"
+// --------------------------------------------------------------------------------------------------------------
+
+unsigned int Apto::RNG::Philox::stateTag() const
+{
+  return 0x584C4850;
+}
+
+int Apto::RNG::Philox::engineStateSize() const
+{
+  return 3 * 8;
+}
+
+void Apto::RNG::Philox::saveEngineState(unsigned char* buffer) const
+{
+  buffer = writeState(buffer, m_key);
+  buffer = writeState(buffer, m_stream);
+  writeState(buffer, m_position);
+}
+
+void Apto::RNG::Philox::restoreEngineState(const unsigned char* buffer)
+{
+  buffer = readState(buffer, m_key);
+  buffer = readState(buffer, m_stream);
+  readState(buffer, m_position);
+  m_block_index = ~0ULL;
+}
+
+
+void Apto::RNG::Philox::FillDouble(double* values, int count)
+{
+  fillDouble(*this, values, count);
+}
+
+void Apto::RNG::Philox::FillUInt(unsigned int* values, int count, unsigned int max)
+{
+  fillUInt(*this, values, count, max);
+}
+
+void Apto::RNG::Philox::FillBernoulli(bool* values, int count, double p)
+{
+  fillBernoulli(*this, values, count, p);
+}
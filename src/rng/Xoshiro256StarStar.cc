@@ -0,0 +1,149 @@
+/*
+ *  Xoshiro256StarStar.cc
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#include "apto/rng/Xoshiro256StarStar.h"
+
+#include "apto/rng/SplitMix64.h"
+
+#include <limits>
+
+
+const int Apto::RNG::Xoshiro256StarStar::MAX_SEED = std::numeric_limits<int>::max();
+
+const uint64_t Apto::RNG::Xoshiro256StarStar::JUMP[4] = {
+  0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL
+};
+const uint64_t Apto::RNG::Xoshiro256StarStar::LONG_JUMP[4] = {
+  0x76E15D3EFEFDCBBFULL, 0xC5004E441C522FB3ULL, 0x77710069854EE241ULL, 0x39109BB02ACBE635ULL
+};
+
+Apto::RNG::Xoshiro256StarStar::~Xoshiro256StarStar() { ; }
+
+
+Apto::Random* Apto::RNG::Xoshiro256StarStar::CreateStream(int stream_id) const
+{
+  // Streams start from the state of this generator's stream key, after the draw ResetSeed consumes, each one jump
+  // (2^128 draws) beyond the last. The jumps are applied to the new stream only, so concurrent calls on a shared
+  // generator are safe.
+  assert(stream_id >= 0);
+  Xoshiro256StarStar* stream = new Xoshiro256StarStar(Seed());
+  expandKey(m_stream_key, stream->m_s);
+  next64(stream->m_s);
+  for (int i = 0; i <= stream_id; i++) stream->Jump();
+  stream->m_stream_key = SplitMix64::StreamKey(m_stream_key, stream_id);
+  return stream;
+}
+
+
+void Apto::RNG::Xoshiro256StarStar::Jump()
+{
+  jump(JUMP);
+}
+
+void Apto::RNG::Xoshiro256StarStar::LongJump()
+{
+  jump(LONG_JUMP);
+}
+
+
+void Apto::RNG::Xoshiro256StarStar::reset()
+{
+  m_stream_key = static_cast<uint64_t>(Seed());
+  expandKey(m_stream_key, m_s);
+}
+
+
+unsigned int Apto::RNG::Xoshiro256StarStar::getNext()
+{
+  return next();
+}
+
+
+// Checkpoint layout, tagged "X256"
+// --------------------------------------------------------------------------------------------------------------
+
+unsigned int Apto::RNG::Xoshiro256StarStar::stateTag() const
+{
+  return 0x36353258;
+}
+
+int Apto::RNG::Xoshiro256StarStar::engineStateSize() const
+{
+  return 5 * 8;
+}
+
+void Apto::RNG::Xoshiro256StarStar::saveEngineState(unsigned char* buffer) const
+{
+  for (int i = 0; i < 4; i++) buffer = writeState(buffer, m_s[i]);
+  writeState(buffer, m_stream_key);
+}
+
+void Apto::RNG::Xoshiro256StarStar::restoreEngineState(const unsigned char* buffer)
+{
+  for (int i = 0; i < 4; i++) buffer = readState(buffer, m_s[i]);
+  readState(buffer, m_stream_key);
+}
+
+
+void Apto::RNG::Xoshiro256StarStar::FillDouble(double* values, int count)
+{
+  fillDouble(*this, values, count);
+}
+
+void Apto::RNG::Xoshiro256StarStar::FillUInt(unsigned int* values, int count, unsigned int max)
+{
+  fillUInt(*this, values, count, max);
+}
+
+void Apto::RNG::Xoshiro256StarStar::FillBernoulli(bool* values, int count, double p)
+{
+  fillBernoulli(*this, values, count, p);
+}
+
+
+void Apto::RNG::Xoshiro256StarStar::jump(uint64_t* state, const uint64_t* polynomial)
+{
+  uint64_t s[4] = { 0, 0, 0, 0 };
+  for (int i = 0; i < 4; i++) {
+    for (int b = 0; b < 64; b++) {
+      if (polynomial[i] & (static_cast<uint64_t>(1) << b)) {
+        for (int j = 0; j < 4; j++) s[j] ^= state[j];
+      }
+      next64(state);
+    }
+  }
+  for (int j = 0; j < 4; j++) state[j] = s[j];
+}
+
+void Apto::RNG::Xoshiro256StarStar::expandKey(uint64_t key, uint64_t* state)
+{
+  // Expand the key into the full state with SplitMix64, as recommended by the authors. The result is never all zero.
+  for (int i = 0; i < 4; i++) state[i] = SplitMix64::Next(key);
+}
@@ -0,0 +1,313 @@
+/*
+ *  Concurrent.cc
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#include "apto/scheduler/Concurrent.h"
+
+#include <cmath>
+
+
+Apto::Scheduler::Concurrent::Concurrent(int entry_count, int num_workers, ShardFactory factory)
+  : m_entry_count(entry_count), m_deterministic(false), m_shards(num_workers), m_workers(num_workers)
+  , m_entry_shard(entry_count), m_entry_local(entry_count), m_priority(entry_count)
+{
+  assert(num_workers > 0);
+  
+  const int shard_capacity = (entry_count + num_workers - 1) / num_workers;
+  for (int i = 0; i < num_workers; i++) {
+    m_shards[i] = new Shard(factory(shard_capacity, i), shard_capacity);
+    m_workers[i] = new Worker(*this, i);
+  }
+  
+  setupEntries();
+}
+
+Apto::Scheduler::Concurrent::Concurrent(int entry_count, int num_workers, SmartPtr<Random> rng,
+                                        StreamShardFactory factory)
+  : m_entry_count(entry_count), m_deterministic(true), m_shards(num_workers), m_workers(num_workers)
+  , m_entry_shard(entry_count), m_entry_local(entry_count), m_priority(entry_count)
+{
+  assert(num_workers > 0);
+  
+  const int shard_capacity = (entry_count + num_workers - 1) / num_workers;
+  for (int i = 0; i < num_workers; i++) {
+    Random* stream = rng->CreateStream(i);
+    assert(stream);
+    m_shards[i] = new Shard(factory(shard_capacity, SmartPtr<Random>(stream)), shard_capacity);
+    m_workers[i] = new Worker(*this, i);
+  }
+  
+  setupEntries();
+}
+
+Apto::Scheduler::Concurrent::~Concurrent()
+{
+  for (int i = 0; i < m_shards.GetSize(); i++) delete m_shards[i];
+  for (int i = 0; i < m_workers.GetSize(); i++) delete m_workers[i];
+}
+
+
+void Apto::Scheduler::Concurrent::AdjustPriority(int entry_id, double priority)
+{
+  if (m_deterministic) {
+    m_deferred.Push(Pair<int, double>(entry_id, priority));
+    return;
+  }
+  
+  postAdjustment(m_entry_shard[entry_id], entry_id, priority);
+}
+
+
+void Apto::Scheduler::Concurrent::Synchronize()
+{
+  for (int i = 0; i < m_shards.GetSize(); i++) processPending(*m_shards[i]);
+  
+  if (!m_deterministic) return;
+  
+  // Apply deferred adjustments in a fixed order, each worker in turn followed by any posted to the scheduler itself
+  for (int w = 0; w < m_workers.GetSize(); w++) {
+    Array<Pair<int, double>, Smart>& deferred = m_workers[w]->m_deferred;
+    for (int i = 0; i < deferred.GetSize(); i++) {
+      const int entry_id = deferred[i].Value1();
+      applyAdjustment(*m_shards[m_entry_shard[entry_id]], entry_id, deferred[i].Value2());
+    }
+    deferred.Resize(0);
+  }
+  
+  for (int i = 0; i < m_deferred.GetSize(); i++) {
+    const int entry_id = m_deferred[i].Value1();
+    applyAdjustment(*m_shards[m_entry_shard[entry_id]], entry_id, m_deferred[i].Value2());
+  }
+  m_deferred.Resize(0);
+}
+
+
+bool Apto::Scheduler::Concurrent::Rebalance(double tolerance)
+{
+  Synchronize();
+  
+  const int num_shards = m_shards.GetSize();
+  if (num_shards == 1) return false;
+  
+  // Only rebalance when the heaviest shard deviates from the mean by more than the requested tolerance
+  double total_weight = 0.0;
+  double max_weight = 0.0;
+  for (int i = 0; i < num_shards; i++) {
+    total_weight += m_shards[i]->weight;
+    if (m_shards[i]->weight > max_weight) max_weight = m_shards[i]->weight;
+  }
+  if (max_weight <= (total_weight / num_shards) * (1.0 + tolerance)) return false;
+  
+  
+  // Group active entries by priority magnitude (binary exponent), approximating a descending sort
+  static const int MAX_EXPONENT = 64;
+  Array<Array<int, Smart> > magnitudes(MAX_EXPONENT + 1);
+  Array<int, Smart> inactive;
+  for (int entry_id = 0; entry_id < m_entry_count; entry_id++) {
+    if (m_priority[entry_id] > 0.0) {
+      int exponent;
+      frexp(m_priority[entry_id], &exponent);
+      if (exponent < 0) exponent = 0;
+      if (exponent > MAX_EXPONENT) exponent = MAX_EXPONENT;
+      magnitudes[exponent].Push(entry_id);
+    } else {
+      inactive.Push(entry_id);
+    }
+  }
+  
+  // Assign entries, largest first, to the lightest shard that has remaining capacity
+  const int shard_capacity = m_shards[0]->entries.GetSize();
+  Array<double> new_weight(num_shards);
+  Array<int> new_count(num_shards);
+  Array<int> new_shard(m_entry_count);
+  Array<int> new_local(m_entry_count);
+  new_weight.SetAll(0.0);
+  new_count.SetAll(0);
+  
+  for (int exponent = MAX_EXPONENT; exponent >= 0; exponent--) {
+    for (int i = 0; i < magnitudes[exponent].GetSize(); i++) {
+      const int entry_id = magnitudes[exponent][i];
+      int target = -1;
+      for (int s = 0; s < num_shards; s++) {
+        if (new_count[s] < shard_capacity && (target < 0 || new_weight[s] < new_weight[target])) target = s;
+      }
+      new_shard[entry_id] = target;
+      new_local[entry_id] = new_count[target]++;
+      new_weight[target] += m_priority[entry_id];
+    }
+  }
+  
+  int target = 0;
+  for (int i = 0; i < inactive.GetSize(); i++) {
+    while (new_count[target] == shard_capacity) target++;
+    new_shard[inactive[i]] = target;
+    new_local[inactive[i]] = new_count[target]++;
+  }
+  
+  
+  // Remove all relocated entries from their old shards before inserting any, since local IDs are reused
+  for (int entry_id = 0; entry_id < m_entry_count; entry_id++) {
+    if (new_shard[entry_id] == m_entry_shard[entry_id] && new_local[entry_id] == m_entry_local[entry_id]) continue;
+    
+    Shard& old_shard = *m_shards[m_entry_shard[entry_id]];
+    old_shard.entries[m_entry_local[entry_id]] = -1;
+    if (m_priority[entry_id] > 0.0) old_shard.scheduler->AdjustPriority(m_entry_local[entry_id], 0.0);
+  }
+  
+  for (int entry_id = 0; entry_id < m_entry_count; entry_id++) {
+    if (new_shard[entry_id] == m_entry_shard[entry_id] && new_local[entry_id] == m_entry_local[entry_id]) continue;
+    
+    m_entry_shard[entry_id] = new_shard[entry_id];
+    m_entry_local[entry_id] = new_local[entry_id];
+    
+    Shard& shard = *m_shards[new_shard[entry_id]];
+    shard.entries[new_local[entry_id]] = entry_id;
+    if (m_priority[entry_id] > 0.0) shard.scheduler->AdjustPriority(new_local[entry_id], m_priority[entry_id]);
+  }
+  
+  for (int i = 0; i < num_shards; i++) {
+    m_shards[i]->weight = new_weight[i];
+    m_shards[i]->active_count = 0;
+  }
+  for (int entry_id = 0; entry_id < m_entry_count; entry_id++) {
+    if (m_priority[entry_id] > 0.0) m_shards[m_entry_shard[entry_id]]->active_count++;
+  }
+  
+  return true;
+}
+
+
+double Apto::Scheduler::Concurrent::ShardWeight(int shard_id) const
+{
+  return m_shards[shard_id]->weight;
+}
+
+
+void Apto::Scheduler::Concurrent::setupEntries()
+{
+  // Distribute entries across the shards in an interleaved fashion
+  const int num_shards = m_shards.GetSize();
+  for (int entry_id = 0; entry_id < m_entry_count; entry_id++) {
+    const int shard_id = entry_id % num_shards;
+    const int local_id = entry_id / num_shards;
+    m_entry_shard[entry_id] = shard_id;
+    m_entry_local[entry_id] = local_id;
+    m_shards[shard_id]->entries[local_id] = entry_id;
+  }
+  
+  m_priority.SetAll(0.0);
+}
+
+
+int Apto::Scheduler::Concurrent::next(int shard_id)
+{
+  Shard& shard = *m_shards[shard_id];
+  
+  if (Atomic::Get(shard.pending_count)) processPending(shard);
+  
+  // Sub-schedulers are not required to handle being empty, so check here
+  if (shard.active_count == 0) return -1;
+  
+  int local_id = shard.scheduler->Next();
+  return (local_id < 0) ? -1 : shard.entries[local_id];
+}
+
+
+void Apto::Scheduler::Concurrent::postAdjustment(int shard_id, int entry_id, double priority)
+{
+  Shard& shard = *m_shards[shard_id];
+  
+  shard.pending_mutex.Lock();
+  shard.pending.Push(Pair<int, double>(entry_id, priority));
+  Atomic::Inc(shard.pending_count);
+  shard.pending_mutex.Unlock();
+}
+
+
+void Apto::Scheduler::Concurrent::processPending(Shard& shard)
+{
+  shard.pending_mutex.Lock();
+  shard.processing = shard.pending;
+  shard.pending.Resize(0);
+  Atomic::Set(shard.pending_count, 0);
+  shard.pending_mutex.Unlock();
+  
+  for (int i = 0; i < shard.processing.GetSize(); i++) {
+    applyAdjustment(shard, shard.processing[i].Value1(), shard.processing[i].Value2());
+  }
+  shard.processing.Resize(0);
+}
+
+
+void Apto::Scheduler::Concurrent::applyAdjustment(Shard& shard, int entry_id, double priority)
+{
+  if (priority < 0.0) priority = 0.0;
+  
+  const double old_priority = m_priority[entry_id];
+  if (old_priority == priority) return;
+  
+  if (old_priority > 0.0 && priority == 0.0) shard.active_count--;
+  else if (old_priority == 0.0 && priority > 0.0) shard.active_count++;
+  
+  shard.weight += priority - old_priority;
+  m_priority[entry_id] = priority;
+  shard.scheduler->AdjustPriority(m_entry_local[entry_id], priority);
+}
+
+
+
+Apto::Scheduler::Concurrent::Worker::~Worker() { ; }
+
+void Apto::Scheduler::Concurrent::Worker::AdjustPriority(int entry_id, double priority)
+{
+  if (m_sched.m_deterministic) {
+    m_deferred.Push(Pair<int, double>(entry_id, priority));
+    return;
+  }
+  
+  const int shard_id = m_sched.m_entry_shard[entry_id];
+  if (shard_id == m_worker_id) {
+    // Entry belongs to this worker's shard, apply directly once earlier adjustments have been processed
+    Shard& shard = *m_sched.m_shards[shard_id];
+    if (Atomic::Get(shard.pending_count)) m_sched.processPending(shard);
+    m_sched.applyAdjustment(shard, entry_id, priority);
+  } else {
+    m_sched.postAdjustment(shard_id, entry_id, priority);
+  }
+}
+
+int Apto::Scheduler::Concurrent::Worker::Next()
+{
+  return m_sched.next(m_worker_id);
+}
+
+int Apto::Scheduler::Concurrent::Worker::EntryLimit() const
+{
+  return m_sched.m_entry_count;
+}
@@ -37,7 +37,7 @@
 
 
 Apto::Scheduler::ProbabilisticIntegrated::ProbabilisticIntegrated(int entry_count, SmartPtr<Random> rng)
-  : m_rng(rng), m_priority_chart(entry_count), m_total_weight(0.0)
+  : m_rng(rng), m_priority_chart(entry_count), m_alias_dirty(true)
 {
   m_priority_chart.SetAll(0.0);
 }
@@ -68,22 +68,20 @@ void Apto::Scheduler::ProbabilisticIntegrated::AdjustPriority(int entry_id, doub
     
     if (old_bit && !new_bit) {
       // Remove the item from this node...
-      m_total_weight -= m_node_weight[i];
       m_node_array[i]->Remove(entry_id);
+      m_alias_dirty = true;
       if (m_node_array[i]->Size() == 0) {
         m_node_weight[i] = 0.0;
         removeNode(i);
       } else {
         m_node_weight[i] = pow(2.0, i) * m_node_array[i]->Size();
-        m_total_weight += m_node_weight[i];
       }
     } else if (!old_bit && new_bit) {
       // Add the item from this node...
       if (i >= m_node_array.GetSize() || !m_node_array[i] || !m_node_array[i]->Size()) insertNode(i);
-      m_total_weight -= m_node_weight[i];
       m_node_array[i]->Insert(entry_id);
+      m_alias_dirty = true;
       m_node_weight[i] = pow(2.0, i) * m_node_array[i]->Size();
-      m_total_weight += m_node_weight[i];
     }
   }
 }
@@ -91,20 +89,18 @@ void Apto::Scheduler::ProbabilisticIntegrated::AdjustPriority(int entry_id, doub
 
 int Apto::Scheduler::ProbabilisticIntegrated::Next()
 {
-  assert(m_node_array.GetSize() > 0);  // Running scheduler w/ no entries!  
+  assert(m_node_array.GetSize() > 0);  // Running scheduler w/ no entries!
   
-  double position = m_rng->GetDouble(m_total_weight);
-  
-  int node_id = m_node_array.GetSize() - 1;
-  while (position > m_node_weight[node_id]) {
-    position -= m_node_weight[node_id];
-    node_id--;
-  }
+  if (m_alias_dirty) rebuildAlias();
+  return drawEntry();
+}
+
+void Apto::Scheduler::ProbabilisticIntegrated::NextBatch(Array<int>& entry_ids)
+{
+  assert(m_node_array.GetSize() > 0);  // Running scheduler w/ no entries!
   
-  Node* cur_node = m_node_array[node_id];
-//int relative_position = round((position / m_node_weight[node_id]) * (cur_node->Size() - 1));
-  int relative_position = floor(((position / m_node_weight[node_id]) * (cur_node->Size() - 1)) + 0.5);  
-  return cur_node->active_entries[relative_position];
+  if (m_alias_dirty) rebuildAlias();
+  for (int i = 0; i < entry_ids.GetSize(); i++) entry_ids[i] = drawEntry();
 }
 
 
@@ -168,6 +164,63 @@ void Apto::Scheduler::ProbabilisticIntegrated::removeNode(int node_id)
   }
 }
 
+inline int Apto::Scheduler::ProbabilisticIntegrated::drawEntry()
+{
+  // A single draw selects both the alias table column and the coin flip within it
+  double position = m_rng->GetDouble(m_alias.GetSize());
+  int column = static_cast<int>(position);
+  if (column >= m_alias.GetSize()) column = m_alias.GetSize() - 1;
+  int node_id = ((position - column) < m_alias_prob[column]) ? column : m_alias[column];
+  
+  // Entries within a node share its weight equally
+  Node* cur_node = m_node_array[node_id];
+  int entry_idx = static_cast<int>(m_rng->GetDouble(cur_node->Size()));
+  if (entry_idx >= cur_node->Size()) entry_idx = cur_node->Size() - 1;
+  return cur_node->active_entries[entry_idx];
+}
+
+void Apto::Scheduler::ProbabilisticIntegrated::rebuildAlias()
+{
+  // Vose's alias method. Columns are scaled so that the average weight is 1.0, then each under-full column is topped
+  // off with the excess of an over-full one. The work array holds under-full columns at the front and over-full
+  // columns at the back.
+  const int num_nodes = m_node_weight.GetSize();
+  m_alias_prob.Resize(num_nodes);
+  m_alias.Resize(num_nodes);
+  m_alias_work.Resize(num_nodes);
+  
+  double total_weight = 0.0;
+  for (int i = 0; i < num_nodes; i++) total_weight += m_node_weight[i];
+  assert(total_weight > 0.0);
+  
+  int small_count = 0;
+  int large_start = num_nodes;
+  for (int i = 0; i < num_nodes; i++) {
+    m_alias_prob[i] = m_node_weight[i] * num_nodes / total_weight;
+    m_alias[i] = i;
+    if (m_alias_prob[i] < 1.0) m_alias_work[small_count++] = i;
+    else m_alias_work[--large_start] = i;
+  }
+  
+  while (small_count > 0 && large_start < num_nodes) {
+    int small_id = m_alias_work[--small_count];
+    int large_id = m_alias_work[large_start];
+    m_alias[small_id] = large_id;
+    m_alias_prob[large_id] = (m_alias_prob[large_id] + m_alias_prob[small_id]) - 1.0;
+    if (m_alias_prob[large_id] < 1.0) {
+      large_start++;
+      m_alias_work[small_count++] = large_id;
+    }
+  }
+  
+  // Whatever remains is full, up to rounding error
+  while (large_start < num_nodes) m_alias_prob[m_alias_work[large_start++]] = 1.0;
+  while (small_count > 0) m_alias_prob[m_alias_work[--small_count]] = 1.0;
+  
+  m_alias_dirty = false;
+}
+
+
 void Apto::Scheduler::ProbabilisticIntegrated::resizeNodes(int new_max)
 {
   int old_size = m_node_array.GetSize();
@@ -180,6 +233,7 @@ void Apto::Scheduler::ProbabilisticIntegrated::resizeNodes(int new_max)
   
   m_node_array.Resize(new_size);
   m_node_weight.Resize(new_size);
+  m_alias_dirty = true;
   
   // Mark as NULL any new cells added to the array.
   for (int i = old_size; i < new_size; i++) {
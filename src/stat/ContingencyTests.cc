@@ -0,0 +1,183 @@
+/*
+ *  ContingencyTests.cc
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#include "apto/stat/Functions.h"
+
+#include "apto/stat/ContingencyTable.h"
+
+#include <cfloat>
+#include <cmath>
+#include <limits>
+
+
+// Internal Definitions
+// --------------------------------------------------------------------------------------------------------------
+
+static const int MAX_GAMMA_ITERATIONS = 1000;
+
+
+// Regularized upper incomplete gamma function Q(a, x), by its series for x < a + 1 and its continued fraction
+// (evaluated with the modified Lentz method) otherwise, as in Numerical Recipes
+static double upperIncompleteGamma(double a, double x)
+{
+  if (x <= 0.0) return 1.0;
+  const double prefix = exp(a * log(x) - x - lgamma(a));
+  
+  if (x < a + 1.0) {
+    double term = 1.0 / a;
+    double sum = term;
+    for (int n = 1; n < MAX_GAMMA_ITERATIONS; n++) {
+      term *= x / (a + n);
+      sum += term;
+      if (fabs(term) < fabs(sum) * DBL_EPSILON) break;
+    }
+    return 1.0 - sum * prefix;
+  }
+  
+  double b = x + 1.0 - a;
+  double c = 1.0 / DBL_MIN;
+  double d = 1.0 / b;
+  double h = d;
+  for (int n = 1; n < MAX_GAMMA_ITERATIONS; n++) {
+    const double an = -n * (n - a);
+    b += 2.0;
+    d = an * d + b;
+    if (fabs(d) < DBL_MIN) d = DBL_MIN;
+    c = b + an / c;
+    if (fabs(c) < DBL_MIN) c = DBL_MIN;
+    d = 1.0 / d;
+    const double delta = d * c;
+    h *= delta;
+    if (fabs(delta - 1.0) < DBL_EPSILON) break;
+  }
+  return prefix * h;
+}
+
+
+static double chiSquarePValue(double statistic, int df)
+{
+  if (df == 0) return 1.0;  // a single row or column, every table with these marginals is the observed table
+  return upperIncompleteGamma(0.5 * df, 0.5 * statistic);
+}
+
+
+// Calculates the chi-square and G statistics of the table in a single pass over its cells, with the expected count
+// of each cell taken from the marginals. Rows and columns with zero marginals have no expected counts, and are left
+// out of the degrees of freedom.
+static void independenceStatistics(const Apto::Stat::ContingencyTable& table, int& df, double& chi_square, double& g)
+{
+  const Apto::Array<int>& row_marginals = table.RowMarginals();
+  const Apto::Array<int>& col_marginals = table.ColMarginals();
+  const double total = table.MarginalTotal();
+  
+  int rows = 0;
+  int cols = 0;
+  for (int j = 0; j < table.NumCols(); j++) if (col_marginals[j] > 0) cols++;
+  
+  chi_square = 0.0;
+  g = 0.0;
+  for (int i = 0; i < table.NumRows(); i++) {
+    if (row_marginals[i] == 0) continue;
+    rows++;
+    const double row_share = row_marginals[i] / total;
+    for (int j = 0; j < table.NumCols(); j++) {
+      if (col_marginals[j] == 0) continue;
+      const double expected = row_share * col_marginals[j];
+      const double observed = table.ElementAt(i, j);
+      const double diff = observed - expected;
+      chi_square += diff * diff / expected;
+      if (observed > 0.0) g += observed * log(observed / expected);
+    }
+  }
+  g *= 2.0;
+  df = (rows - 1) * (cols - 1);
+}
+
+
+
+// Exported Function Definitions
+// --------------------------------------------------------------------------------------------------------------
+
+double Apto::Stat::ChiSquareTest(const ContingencyTable& table)
+{
+  if (table.MarginalTotal() == 0) return std::numeric_limits<double>::quiet_NaN();  // All elements are 0
+  
+  int df;
+  double chi_square, g;
+  independenceStatistics(table, df, chi_square, g);
+  return chiSquarePValue(chi_square, df);
+}
+
+
+double Apto::Stat::GTest(const ContingencyTable& table)
+{
+  if (table.MarginalTotal() == 0) return std::numeric_limits<double>::quiet_NaN();  // All elements are 0
+  
+  int df;
+  double chi_square, g;
+  independenceStatistics(table, df, chi_square, g);
+  return chiSquarePValue(g, df);
+}
+
+
+void Apto::Stat::ContingencyTests(const Array<ContingencyTable>& tables, Array<ContingencyTestResult>& results,
+                                  double exact_threshold)
+{
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  results.ResizeClear(tables.GetSize());
+  Array<int, Smart> flagged;
+  
+  for (int t = 0; t < tables.GetSize(); t++) {
+    const ContingencyTable& table = tables[t];
+    ContingencyTestResult& result = results[t];
+    
+    if (table.MarginalTotal() == 0) {  // All elements are 0
+      result.df = 0;
+      result.chi_square = result.chi_square_pvalue = result.g = result.g_pvalue = result.mid_p = nan;
+      continue;
+    }
+    
+    independenceStatistics(table, result.df, result.chi_square, result.g);
+    result.chi_square_pvalue = chiSquarePValue(result.chi_square, result.df);
+    result.g_pvalue = chiSquarePValue(result.g, result.df);
+    
+    // Exact tests only for the tables the approximate tests flag
+    result.mid_p = nan;
+    if (result.chi_square_pvalue <= exact_threshold || result.g_pvalue <= exact_threshold) flagged.Push(t);
+  }
+  if (flagged.GetSize() == 0) return;
+  
+  // The flagged tables are tested as one batch, spread across the worker pool
+  Array<ContingencyTable> exact_tables(flagged.GetSize());
+  for (int i = 0; i < flagged.GetSize(); i++) exact_tables[i] = tables[flagged[i]];
+  Array<double> mid_p;
+  FishersExactMidP(exact_tables, mid_p);
+  for (int i = 0; i < flagged.GetSize(); i++) results[flagged[i]].mid_p = mid_p[i];
+}
@@ -41,18 +41,23 @@
 
 #include "apto/stat/ContingencyTable.h"
 #include "apto/stat/Functions.h"
+#include "apto/stat/LogFactorial.h"
 
 #include "apto/core/Array.h"
 #include "apto/core/ArrayUtils.h"
 #include "apto/core/ConditionVariable.h"
+#include "apto/core/List.h"
 #include "apto/core/Mutex.h"
 #include "apto/core/Pair.h"
-#include "apto/core/RefCount.h"
+#include "apto/core/Random.h"
+#include "apto/core/Singleton.h"
 #include "apto/core/SmartPtr.h"
 #include "apto/core/Thread.h"
 
+#include <cfloat>
 #include <cmath>
 #include <limits>
+#include <stdint.h>
 
 #include <iostream>
 #include <stdio.h>
@@ -66,6 +71,18 @@ using namespace Apto;
 static const double TOLERANCE = 3.4525e-7;  // Tolerance, as used in Algorithm 643
 static const int THREADING_THRESHOLD = 20;
 static const int DEFAULT_TABLE_SIZE = 300;
+static const int MONTE_CARLO_STREAMS = 16;      // fixed, so estimates do not depend on the number of CPUs
+static const int MONTE_CARLO_BLOCK = 256;       // samples per stream per round
+static const double MONTE_CARLO_Z = 1.959964;   // 95% confidence
+static const int TWO_ROW_MAX_COLS = 32;
+static const int TWO_ROW_NODE_BUDGET = 1024;     // nodes visited before a 2 x c table falls back to FExact
+
+
+
+// Internal Function Declarations
+// -------------------------------------------------------------------------------------------------------------- 
+
+static double fishersExact(const Stat::ContingencyTable& table, bool mid_p);
 
 
 
@@ -110,6 +127,255 @@ public:
 };
 
 typedef Array<int, Smart> MarginalArray;
+typedef int64_t FExactKey;
+
+
+// FExactKeyMap - maps marginal vectors to node keys and back
+// -------------------------------------------------------------------------------------------------------------- 
+//
+// Vectors are packed into a single mixed radix key when every vector the radices allow fits in 63 bits. Otherwise
+// each distinct vector is interned in an open addressed table, hashed over all of its values, and keyed by its
+// interning order. Either way keys are non-negative, so tables may use -1 to mark empty entries.
+
+class FExactKeyMap
+{
+private:
+  int m_width;
+  Array<FExactKey> m_multipliers;   // packed digit weights, empty when interning
+  
+  Array<int, Smart> m_values;       // interned vectors, m_width values each, in key order
+  Array<FExactKey> m_slots;         // interned keys by hash, -1 when empty
+  int m_count;
+  
+public:
+  FExactKeyMap() : m_width(0), m_count(0) { ; }
+  
+  // Digit i of every vector passed to Key() must lie in [0, radix[i])
+  template <class A> void Setup(const A& radix)
+  {
+    m_width = radix.GetSize();
+    m_multipliers.Resize(m_width);
+    FExactKey multiplier = 1;
+    for (int i = 0; i < m_width; i++) {
+      m_multipliers[i] = multiplier;
+      if (multiplier > std::numeric_limits<FExactKey>::max() / radix[i]) {
+        // Key space exceeds 63 bits, intern vectors instead
+        m_multipliers.Resize(0);
+        m_slots.Resize(1024);
+        m_slots.SetAll(-1);
+        return;
+      }
+      multiplier *= radix[i];
+    }
+  }
+  
+  inline bool IsPacked() const { return m_multipliers.GetSize() > 0; }
+  
+  template <class A> inline FExactKey Key(const A& values)
+  {
+    if (IsPacked()) {
+      FExactKey key = values[0];
+      for (int i = 1; i < m_width; i++) key += values[i] * m_multipliers[i];
+      return key;
+    }
+    return intern(values);
+  }
+  
+  template <class A> inline void Unpack(FExactKey key, A& values) const
+  {
+    if (IsPacked()) {
+      for (int i = m_width - 1; i > 0; i--) {
+        values[i] = (int)(key / m_multipliers[i]);
+        key -= values[i] * m_multipliers[i];
+      }
+      values[0] = (int)key;
+    } else {
+      const int offset = (int)key * m_width;
+      for (int i = 0; i < m_width; i++) values[i] = m_values[offset + i];
+    }
+  }
+  
+private:
+  template <class A> static inline uint64_t hash(const A& values, int width)
+  {
+    uint64_t hash = 14695981039346656037ULL;  // FNV-1a over the values
+    for (int i = 0; i < width; i++) hash = (hash ^ (uint64_t)(unsigned int)values[i]) * 1099511628211ULL;
+    return hash;
+  }
+  
+  template <class A> FExactKey intern(const A& values)
+  {
+    const uint64_t mask = m_slots.GetSize() - 1;
+    uint64_t slot = hash(values, m_width) & mask;
+    for (; m_slots[slot] >= 0; slot = (slot + 1) & mask) {
+      const int offset = (int)m_slots[slot] * m_width;
+      int i = 0;
+      while (i < m_width && m_values[offset + i] == values[i]) i++;
+      if (i == m_width) return m_slots[slot];
+    }
+    
+    FExactKey key = m_count++;
+    m_values.Resize(m_count * m_width);
+    for (int i = 0; i < m_width; i++) m_values[(int)key * m_width + i] = values[i];
+    m_slots[slot] = key;
+    
+    if (m_count * 4 > m_slots.GetSize() * 3) {
+      m_slots.ResizeClear(m_slots.GetSize() * 2);
+      m_slots.SetAll(-1);
+      const uint64_t grown_mask = m_slots.GetSize() - 1;
+      for (int k = 0; k < m_count; k++) {
+        uint64_t grown_slot = hash(&m_values[k * m_width], m_width) & grown_mask;
+        while (m_slots[grown_slot] >= 0) grown_slot = (grown_slot + 1) & grown_mask;
+        m_slots[grown_slot] = k;
+      }
+    }
+    return key;
+  }
+};
+
+
+// FExactWorkerPool - persistent worker threads shared by all FishersExact calls
+// -------------------------------------------------------------------------------------------------------------- 
+//
+// Workers are started when the pool is first used and live until process exit. Tasks submitted to the pool are
+// tracked by a TaskGroup, which the submitter waits on before releasing the task objects. A task may be submitted
+// more than once, in which case each submission calls Process() from a different worker. Tasks run in submission
+// order and must not block waiting on their submitter, so that work from concurrent callers interleaves.
+
+class FExactWorkerPool
+{
+public:
+  class Task
+  {
+  public:
+    virtual ~Task() { ; }
+    
+    virtual void Process() = 0;
+  };
+  
+  class TaskGroup
+  {
+    friend class FExactWorkerPool;
+  private:
+    Mutex m_mutex;
+    ConditionVariable m_cond;
+    int m_pending;
+    
+  public:
+    TaskGroup() : m_pending(0) { ; }
+    
+    void Wait()
+    {
+      MutexAutoLock lock(m_mutex);
+      while (m_pending) m_cond.Wait(m_mutex);
+    }
+  };
+  
+private:
+  class Worker : public Thread
+  {
+  private:
+    FExactWorkerPool* m_pool;
+    
+  public:
+    Worker(FExactWorkerPool* pool) : m_pool(pool) { ; }
+  protected:
+    void Run() { m_pool->work(); }
+  };
+  
+  struct QueuedTask
+  {
+    Task* task;
+    TaskGroup* group;
+  };
+  
+  Mutex m_mutex;
+  ConditionVariable m_cond;
+  List<QueuedTask> m_queue;
+  Array<Worker*> m_workers;
+  bool m_shutdown;
+  
+public:
+  FExactWorkerPool();
+  ~FExactWorkerPool();
+  
+  static inline FExactWorkerPool& Instance()
+  {
+    return SingletonHolder<FExactWorkerPool, CreateWithNew, DestroyAtExit, ThreadSafe>::Instance();
+  }
+  
+  inline int NumWorkers() const { return m_workers.GetSize(); }
+  
+  void Submit(Task* task, TaskGroup& group);
+  
+private:
+  void work();
+};
+
+
+FExactWorkerPool::FExactWorkerPool() : m_shutdown(false)
+{
+#if APTO_PLATFORM(THREADS)
+  m_workers.Resize(Platform::AvailableCPUs());
+  for (int i = 0; i < m_workers.GetSize(); i++) {
+    m_workers[i] = new Worker(this);
+    m_workers[i]->Start();
+  }
+#endif
+}
+
+
+FExactWorkerPool::~FExactWorkerPool()
+{
+  m_mutex.Lock();
+  m_shutdown = true;
+  m_mutex.Unlock();
+  m_cond.Broadcast();
+  
+  for (int i = 0; i < m_workers.GetSize(); i++) {
+    m_workers[i]->Join();
+    delete m_workers[i];
+  }
+}
+
+
+void FExactWorkerPool::Submit(Task* task, TaskGroup& group)
+{
+  group.m_mutex.Lock();
+  group.m_pending++;
+  group.m_mutex.Unlock();
+  
+  QueuedTask queued;
+  queued.task = task;
+  queued.group = &group;
+  
+  m_mutex.Lock();
+  m_queue.PushRear(queued);
+  m_mutex.Unlock();
+  m_cond.Signal();
+}
+
+
+void FExactWorkerPool::work()
+{
+  while (true) {
+    m_mutex.Lock();
+    while (m_queue.GetSize() == 0 && !m_shutdown) m_cond.Wait(m_mutex);
+    if (m_queue.GetSize() == 0) {
+      m_mutex.Unlock();
+      return;
+    }
+    QueuedTask queued = m_queue.Pop();
+    m_mutex.Unlock();
+    
+    queued.task->Process();
+    
+    // Signal while holding the group lock, the waiter may release the group as soon as it can reacquire it
+    queued.group->m_mutex.Lock();
+    if (--queued.group->m_pending == 0) queued.group->m_cond.Broadcast();
+    queued.group->m_mutex.Unlock();
+  }
+}
 
 
 class FExact
@@ -118,7 +384,7 @@ public:
   // FExact Public Methods
   // ------------------------------------------------------------------------------------------------------------ 
   
-  FExact(const Stat::ContingencyTable& table, double tolerance);
+  FExact(const Stat::ContingencyTable& table, double tolerance, bool mid_p = false);
   
   double Calculate();
   double ThreadedCalculate();
@@ -129,10 +395,9 @@ private:
   // ------------------------------------------------------------------------------------------------------------ 
   
   // Main Node
-  class FExactNode;
   struct PastPathLength;
-  class NodeHashTable;
-  typedef SmartPtr<FExactNode, InternalRCObject> NodePtr;
+  struct StageNode;
+  class StageNodeTable;
 
   
   // Path Extremes
@@ -154,11 +419,11 @@ private:
   // Core Algorithm
   inline bool generateFirstDaughter(const MarginalArray& row_marginals, int n, MarginalArray& row_diff, int& kmax, int& kd);
   bool generateNewDaughter(int kmax, const MarginalArray& row_marginals, MarginalArray& row_diff, int& idx_dec, int& idx_inc);
-  NodePtr handlePastPaths(NodePtr& cur_node, double obs2, double obs3, double ddf, double drn, int kval, NodeHashTable& nht);
-  void recordPath(double path_length, int path_freq, Array<PastPathLength, Smart>& past_entries);
+  int handlePastPaths(StageNodeTable& nodes, int cur_node, double obs2, double obs3, double ddf, double drn,
+                      FExactKey kval, StageNodeTable& nht);
+  void recordPath(double path_length, int path_freq, StageNodeTable& nht, int node);
 
-  void handleNode(int k, NodePtr cur_node);
-  inline void unpackMarginals(int key, MarginalArray& row_marginals);
+  void handleNode(int k, int cur_node);
   
   
   // Longest Path
@@ -182,94 +447,107 @@ private:
     int observed;
     int next_left;
     int next_right;
+    int next;  // next past path of the same node, in insertion order
     
-    PastPathLength(double in_value = 0.0) : value(in_value), observed(1), next_left(-1), next_right(-1) { ; }
-    PastPathLength(double in_value, int in_freq) : value(in_value), observed(in_freq), next_left(-1), next_right(-1) { ; }
+    PastPathLength(double in_value = 0.0) : value(in_value), observed(1), next_left(-1), next_right(-1), next(-1) { ; }
+    PastPathLength(double in_value, int in_freq)
+      : value(in_value), observed(in_freq), next_left(-1), next_right(-1), next(-1) { ; }
   };
   
-  class FExactNode : public RefCountObject<SingleThreaded>
+  struct StageNode
   {
-  public:
-    int key;
-    Array<PastPathLength, Smart> past_entries;
-    
-    FExactNode(int in_key) : key(in_key) { ; }
-    virtual ~FExactNode() { ; }
+    FExactKey key;
+    int first_path;
+    int last_path;
   };
   
-  class NodeHashTable
+  // Nodes of one stage of the network. Nodes and their past paths live in per-stage arenas, addressed by index and
+  // located by key through an open addressed slot table. Clear() resets the stage in bulk and keeps the arena memory
+  // for reuse by a later stage.
+  class StageNodeTable
   {
-  public:
-    typedef SmartPtr<FExactNode, InternalRCObject> NodePtr;
   private:
-    Array<NodePtr> m_table;
-    int m_last;
+    Array<int> m_slots;                    // node indices, -1 when empty
+    Array<StageNode, Smart> m_nodes;       // in insertion order
+    Array<PastPathLength, Smart> m_paths;  // past paths of all nodes in the stage
+    int m_popped;
     
   public:
-    inline NodeHashTable(int size = DEFAULT_TABLE_SIZE) : m_table(size), m_last(-1) { ; }
+    inline StageNodeTable(int size = DEFAULT_TABLE_SIZE) : m_slots(size), m_popped(0) { m_slots.SetAll(-1); }
     
-    bool Find(int key, int& idx)
+    // Locates the node with the given key, adding a node without past paths if there is none. Returns true if the
+    // node already existed.
+    bool Find(FExactKey key, int& node_idx)
     {
-      int init = key % m_table.GetSize();
-      idx = init;
-      for (; idx < m_table.GetSize(); idx++) {
-        if (!m_table[idx]) {
-          m_table[idx] = NodePtr(new FExactNode(key));
-          return false;
-        } else if (m_table[idx]->key == key) {
+      int slot = (int)(key % m_slots.GetSize());
+      for (; m_slots[slot] >= 0; slot = (slot + 1 == m_slots.GetSize()) ? 0 : slot + 1) {
+        if (m_nodes[m_slots[slot]].key == key) {
+          node_idx = m_slots[slot];
           return true;
         }
       }
-      for (idx = 0; idx < init; idx++) {
-        if (!m_table[idx]) {
-          m_table[idx] = NodePtr(new FExactNode(key));
-          return false;
-        } else if (m_table[idx]->key == key) {
-          return true;
-        }
-      }
-      Rehash(key, idx);
+      
+      node_idx = m_nodes.GetSize();
+      m_nodes.Resize(node_idx + 1);
+      m_nodes[node_idx].key = key;
+      m_nodes[node_idx].first_path = -1;
+      m_nodes[node_idx].last_path = -1;
+      m_slots[slot] = node_idx;
+      
+      // Keep probe sequences short by holding the slot table to at most three quarters full
+      if (m_nodes.GetSize() * 4 > m_slots.GetSize() * 3) rehash();
       return false;
     }
     
-    inline FExactNode& operator[](int idx) { return *m_table[idx]; }
-    inline NodePtr Get(int idx) { return m_table[idx]; }
+    inline StageNode& operator[](int idx) { return m_nodes[idx]; }
+    inline PastPathLength& Path(int idx) { return m_paths[idx]; }
     
-    NodePtr Pop()
+    inline int AddPath(int node_idx, const PastPathLength& path)
     {
-      for (++m_last; m_last < m_table.GetSize(); m_last++) {
-        if (m_table[m_last]) {
-          NodePtr tmp = m_table[m_last];
-          m_table[m_last] = NodePtr(NULL);
-          return tmp;
-        }
-      }
-      m_last = -1;
-      return NodePtr(NULL);
+      int path_idx = m_paths.GetSize();
+      m_paths.Push(path);
+      StageNode& node = m_nodes[node_idx];
+      if (node.last_path < 0) node.first_path = path_idx;
+      else m_paths[node.last_path].next = path_idx;
+      node.last_path = path_idx;
+      return path_idx;
+    }
+    
+    // Returns the next node in insertion order, or -1 once all nodes have been returned
+    inline int Pop() { return (m_popped < m_nodes.GetSize()) ? m_popped++ : -1; }
+    
+    void Clear()
+    {
+      m_nodes.SetReserve(m_nodes.GetCapacity());
+      m_nodes.Resize(0);
+      m_paths.SetReserve(m_paths.GetCapacity());
+      m_paths.Resize(0);
+      m_slots.SetAll(-1);
+      m_popped = 0;
     }
+    
   private:
-    void Rehash(int key, int& idx)
+    void rehash()
     {
-      Array<NodePtr> old_table(m_table);
-      m_table.ResizeClear(old_table.GetSize() * 2);
-      for (int i = 0; i < old_table.GetSize(); i++) {
-        int t_idx;
-        Find(old_table[i]->key, t_idx);
-        m_table[t_idx] = old_table[i];
+      m_slots.ResizeClear(m_slots.GetSize() * 2);
+      m_slots.SetAll(-1);
+      for (int i = 0; i < m_nodes.GetSize(); i++) {
+        int slot = (int)(m_nodes[i].key % m_slots.GetSize());
+        while (m_slots[slot] >= 0) slot = (slot + 1 == m_slots.GetSize()) ? 0 : slot + 1;
+        m_slots[slot] = i;
       }
-      Find(key, idx);
     }
   };
 
   
   
   struct PathExtremes {
-    int key;
+    FExactKey key;
     double longest_path;
     double shortest_path;
     PathExtremes() : key(-1) { ; }
     
-    void Set(int in_key, double lp, double sp) { key = in_key; longest_path = lp; shortest_path = sp; }
+    void Set(FExactKey in_key, double lp, double sp) { key = in_key; longest_path = lp; shortest_path = sp; }
   };
   
   class PathExtremesHashTable
@@ -280,9 +558,9 @@ private:
   public:
     inline PathExtremesHashTable(int size = DEFAULT_TABLE_SIZE) : m_table(size) { ClearTable(); }
     
-    bool Find(int key, int& idx)
+    bool Find(FExactKey key, int& idx)
     {
-      int init = key % m_table.GetSize();
+      int init = (int)(key % m_table.GetSize());
       idx = init;
       for (; idx < m_table.GetSize(); idx++) {
         if (m_table[idx].key < 0) {
@@ -312,7 +590,7 @@ private:
     }
     
   private:
-    void Rehash(int key, int& idx)
+    void Rehash(FExactKey key, int& idx)
     {
       Array<PathExtremes> old_table(m_table);
       m_table.ResizeClear(old_table.GetSize() * 2);
@@ -328,7 +606,7 @@ private:
   
   
   struct PendingPathExtremes {
-    int key;
+    FExactKey key;
     bool inprogress;
     MarginalArray rows;
     MarginalArray cols;
@@ -361,9 +639,9 @@ private:
     
     int GetSize() { return m_size; }
     
-    bool Find(int key, int& idx)
+    bool Find(FExactKey key, int& idx)
     {
-      int init = key % m_table.GetSize();
+      int init = (int)(key % m_table.GetSize());
       idx = init;
       for (; idx < m_table.GetSize(); idx++) {
         if (m_table[idx].key < 0) {
@@ -401,7 +679,7 @@ private:
     inline PendingPathExtremes& operator[](int idx) { return m_table[idx]; }
     
   private:
-    void Rehash(int key, int& idx)
+    void Rehash(FExactKey key, int& idx)
     {
       Array<PendingPathExtremes> old_table(m_table);
       m_table.ResizeClear(old_table.GetSize() * 2);
@@ -417,34 +695,33 @@ private:
   
   
   struct PendingPathNode {
-    NodePtr node;
+    int node;
     double obs2;
     double drn;
     double ddf;
-    int kval;
+    FExactKey kval;
     bool k1;
     bool handled;
     
-    PendingPathNode() : node(NULL), handled(false) { ; }
-    inline void Set(NodePtr in_node, double in_obs2, double in_drn, double in_ddf, int in_kval, bool in_k1 = false)
+    PendingPathNode() : node(-1), handled(false) { ; }
+    inline void Set(int in_node, double in_obs2, double in_drn, double in_ddf, FExactKey in_kval,
+                    bool in_k1 = false)
     {
       node = in_node; obs2 = in_obs2; drn = in_drn; ddf = in_ddf; kval = in_kval; k1 = in_k1;
     }
   };
   
     
-  class PathExtremesCalc : public Thread
+  // Submitted once per queued path extremes calculation, each Process() completes one of them
+  class PathExtremesCalc : public FExactWorkerPool::Task
   {
   private:
     FExact* m_fexact;
-    bool m_run;
     
   public:
-    PathExtremesCalc(FExact* fexact) : m_fexact(fexact), m_run(true) { ; }
+    PathExtremesCalc(FExact* fexact) : m_fexact(fexact) { ; }
     
-    void SetFinished() { m_run = false; }
-  protected:
-    void Run();
+    void Process();
   };
   
   
@@ -459,8 +736,8 @@ private:
   // Pre-calculated Values
   MarginalArray m_row_marginals;
   MarginalArray m_col_marginals;
-  Array<double> m_facts; // Log factorials
-  Array<int> m_key_multipliers;
+  const double* m_facts; // Log factorials, from the shared table
+  FExactKeyMap m_keys;
   double m_observed_path;
   double m_den_observed_path;
 
@@ -468,18 +745,24 @@ private:
   // Main Calculated Value
   double m_pvalue;
   
+  // Mid-p support, paths within m_tie_band below the observed path complete only to tables tied with the observed
+  // table, whose probability is also summed into m_tie. The band is empty unless calculating a mid-p value.
+  double m_tie_band;
+  double m_tie;
+  
   
   // Core Algorithm Support
   
   
   // Threaded Core Algorithm Support
-  Array<NodeHashTable> m_nht;
+  StageNodeTable m_nht[2];  // stage k nodes are held in m_nht[k & 0x1]
   Array<Array<PendingPathNode, Smart> >  m_pending_path_nodes;
   Array<PathExtremesHashTable> m_path_extremes;
   
   // Path Extremes Threading Support
+  PathExtremesCalc* m_path_calc;
+  FExactWorkerPool::TaskGroup* m_path_group;
   Mutex m_path_extremes_mutex;
-  ConditionVariable m_path_extremes_cond;
   ConditionVariable m_path_extremes_cond_complete;
   Array<PendingPathExtremesTable> m_pending_path_extremes;
   Array<Array<PathExtremes, Smart> > m_completed_path_extremes;
@@ -489,30 +772,540 @@ private:
 
 
 
+// FExactBatch - small tables of a batch, claimed one at a time by the caller and the pool workers
+// -------------------------------------------------------------------------------------------------------------- 
+
+class FExactBatch : public FExactWorkerPool::Task
+{
+private:
+  const Array<Stat::ContingencyTable>& m_tables;
+  const Array<int, Smart>& m_indices;
+  Array<double>& m_pvalues;
+  const bool m_mid_p;
+  
+  Mutex m_mutex;
+  int m_next;
+  
+public:
+  FExactBatch(const Array<Stat::ContingencyTable>& tables, const Array<int, Smart>& indices, Array<double>& pvalues,
+              bool mid_p)
+    : m_tables(tables), m_indices(indices), m_pvalues(pvalues), m_mid_p(mid_p), m_next(0) { ; }
+  
+  void Process()
+  {
+    while (true) {
+      m_mutex.Lock();
+      int next = m_next++;
+      m_mutex.Unlock();
+      if (next >= m_indices.GetSize()) return;
+      
+      // Small tables never spread their own calculation across the pool
+      m_pvalues[m_indices[next]] = fishersExact(m_tables[m_indices[next]], m_mid_p);
+    }
+  }
+};
+
+
+
+// FExactMonteCarlo - samples random tables sharing the marginals of a table, counting those at least as extreme
+// -------------------------------------------------------------------------------------------------------------- 
+//
+// Tables are drawn with Patefield's algorithm (Applied Statistics AS 159), filling each row cell by cell from the
+// hypergeometric distribution of the cell given the remaining row and column totals. Each sampler owns one stream
+// of random numbers and may run on any pool worker.
+
+class FExactMonteCarlo : public FExactWorkerPool::Task
+{
+private:
+  const Stat::ContingencyTable& m_table;
+  const double* m_facts;
+  double m_extreme;   // sum of cell log factorials at or above which a table is at least as extreme as the observed
+  Random* m_rng;
+  
+  Array<int> m_col_remaining;
+  int m_quota;
+  int m_extreme_count;
+  
+public:
+  FExactMonteCarlo(const Stat::ContingencyTable& table, const double* facts, double extreme, Random* rng)
+    : m_table(table), m_facts(facts), m_extreme(extreme), m_rng(rng), m_col_remaining(table.NumCols())
+    , m_quota(0), m_extreme_count(0) { ; }
+  
+  inline void SetQuota(int quota) { m_quota = quota; m_extreme_count = 0; }
+  inline int ExtremeCount() const { return m_extreme_count; }
+  
+  void Process()
+  {
+    for (int i = 0; i < m_quota; i++) if (sample() >= m_extreme) m_extreme_count++;
+  }
+  
+private:
+  // Samples one table, returning the sum of the log factorials of its cells
+  double sample()
+  {
+    const int nrow = m_table.NumRows();
+    const int ncol = m_table.NumCols();
+    for (int j = 0; j < ncol; j++) m_col_remaining[j] = m_table.ColMarginals()[j];
+    
+    double stat = 0.0;
+    int total_remaining = m_table.MarginalTotal();
+    for (int i = 0; i < nrow - 1; i++) {
+      int row_remaining = m_table.RowMarginals()[i];
+      int pool = total_remaining;
+      total_remaining -= row_remaining;
+      for (int j = 0; j < ncol - 1 && row_remaining > 0; j++) {
+        int x = hypergeometric(pool, m_col_remaining[j], row_remaining);
+        pool -= m_col_remaining[j];
+        m_col_remaining[j] -= x;
+        row_remaining -= x;
+        stat += m_facts[x];
+      }
+      // The last column takes whatever the row has left
+      m_col_remaining[ncol - 1] -= row_remaining;
+      stat += m_facts[row_remaining];
+    }
+    
+    // The last row takes whatever the columns have left
+    for (int j = 0; j < ncol; j++) stat += m_facts[m_col_remaining[j]];
+    
+    return stat;
+  }
+  
+  // Number of successes in draws taken without replacement from total items holding successes, drawn by inversion
+  // outward from the mode
+  int hypergeometric(int total, int successes, int draws)
+  {
+    const int failures = total - successes;
+    const int lo = (draws > failures) ? draws - failures : 0;
+    const int hi = (draws < successes) ? draws : successes;
+    if (lo == hi) return lo;
+    
+    int mode = (int)(((double)draws + 1.0) * ((double)successes + 1.0) / ((double)total + 2.0));
+    if (mode < lo) mode = lo;
+    if (mode > hi) mode = hi;
+    
+    const double p_mode = exp(m_facts[successes] + m_facts[failures] + m_facts[draws] + m_facts[total - draws]
+                              - m_facts[total] - m_facts[mode] - m_facts[successes - mode] - m_facts[draws - mode]
+                              - m_facts[failures - draws + mode]);
+    double u = m_rng->GetDouble() - p_mode;
+    if (u <= 0.0) return mode;
+    
+    int up = mode, down = mode;
+    double p_up = p_mode, p_down = p_mode;
+    while (up < hi || down > lo) {
+      if (up < hi) {
+        p_up *= ((double)(successes - up) * (draws - up)) / ((double)(up + 1) * (failures - draws + up + 1));
+        up++;
+        u -= p_up;
+        if (u <= 0.0) return up;
+      }
+      if (down > lo) {
+        p_down *= ((double)down * (failures - draws + down)) / ((double)(successes - down + 1) * (draws - down + 1));
+        down--;
+        u -= p_down;
+        if (u <= 0.0) return down;
+      }
+    }
+    
+    // Only reached through rounding of the probabilities, which leaves the mode as the best answer
+    return mode;
+  }
+};
+
+
+
+// FExactTwoRow - direct hypergeometric sums for tables with two rows (or two columns)
+// -------------------------------------------------------------------------------------------------------------- 
+//
+// With two rows a table is determined by its first row, and the probability of a table is K - S, where K is fixed by
+// the marginals and S is the sum of the log factorials of the cells. A 2 x 2 table has a single free cell whose
+// probabilities are unimodal, so only the two tails are summed. For 2 x c tables the first row is enumerated column by
+// column, bounding the log factorial sum of the columns not yet placed: subtrees that cannot reach the observed
+// table are skipped, and subtrees that lie wholly beyond it are summed in closed form, as the tables completing a
+// partial first row with k items over columns totaling C have probabilities summing to choose(C, k) / prod(c_j!).
+// Everything lives on the stack, so neither kernel allocates.
+
+class FExactTwoRow
+{
+private:
+  const double* m_facts;
+  double m_extreme;   // sum of cell log factorials at or above which a table is at least as extreme as the observed
+  double m_constant;  // log probability of a table, less its sum of cell log factorials
+  
+  int m_items;       // first row marginal
+  int m_ncol;
+  int m_cols[TWO_ROW_MAX_COLS];
+  int m_suffix_total[TWO_ROW_MAX_COLS + 1];     // sum of the column marginals from each column on
+  double m_suffix_facts[TWO_ROW_MAX_COLS + 1];  // sum of the column marginal log factorials from each column on
+  
+  int m_budget;
+  double m_tie_band;  // width of the band of sums from m_extreme up holding the tables tied with the observed
+  double m_pvalue;
+  double m_tie;       // probability of the tied tables, collected only for mid-p values
+  
+public:
+  // The p-value of the 2 x 2 table, which must not be empty. Mid-p values count tied tables at half weight.
+  static double Calculate2x2(int n11, int n12, int n21, int n22, bool mid_p = false)
+  {
+    const int row1 = n11 + n12, row2 = n21 + n22;
+    const int col1 = n11 + n21, col2 = n12 + n22;
+    const int total = row1 + row2;
+    const double* facts = Stat::LogFactorials(total);
+    
+    const double constant = facts[row1] + facts[row2] + facts[col1] + facts[col2] - facts[total];
+    const double extreme = facts[n11] + facts[n12] + facts[n21] + facts[n22] - TOLERANCE;
+    double tie = 0.0;
+    const double pvalue = tails(facts, constant, extreme, row1, row2, col1, (mid_p) ? &tie : NULL);
+    return pvalue - 0.5 * tie;
+  }
+  
+  // Sets up the network of a table with two rows or two columns, at most TWO_ROW_MAX_COLS along the other side
+  FExactTwoRow(const Stat::ContingencyTable& table, bool mid_p = false)
+    : m_budget(TWO_ROW_NODE_BUDGET), m_tie_band((mid_p) ? 2.0 * TOLERANCE : 0.0), m_pvalue(0.0), m_tie(0.0)
+  {
+    const bool transpose = (table.NumRows() != 2);
+    const Array<int>& rows = (transpose) ? table.ColMarginals() : table.RowMarginals();
+    const Array<int>& cols = (transpose) ? table.RowMarginals() : table.ColMarginals();
+    assert(rows.GetSize() == 2 && cols.GetSize() <= TWO_ROW_MAX_COLS);
+    
+    const int total = table.MarginalTotal();
+    m_facts = Stat::LogFactorials(total);
+    
+    // Empty columns never vary, and larger columns first make the bounds decisive closer to the root
+    m_ncol = 0;
+    for (int j = 0; j < cols.GetSize(); j++) {
+      if (cols[j] == 0) continue;
+      int pos = m_ncol++;
+      for (; pos > 0 && m_cols[pos - 1] < cols[j]; pos--) m_cols[pos] = m_cols[pos - 1];
+      m_cols[pos] = cols[j];
+    }
+    m_suffix_total[m_ncol] = 0;
+    m_suffix_facts[m_ncol] = 0.0;
+    for (int j = m_ncol - 1; j >= 0; j--) {
+      m_suffix_total[j] = m_suffix_total[j + 1] + m_cols[j];
+      m_suffix_facts[j] = m_suffix_facts[j + 1] + m_facts[m_cols[j]];
+    }
+    
+    m_items = rows[0];
+    m_constant = m_facts[rows[0]] + m_facts[rows[1]] + m_suffix_facts[0] - m_facts[total];
+    
+    double observed = 0.0;
+    for (int i = 0; i < table.NumRows(); i++) {
+      for (int j = 0; j < table.NumCols(); j++) observed += m_facts[table.ElementAt(i, j)];
+    }
+    m_extreme = observed - TOLERANCE;
+  }
+  
+  // Calculates the p-value, returning false if the network exceeded its node budget
+  bool Calculate(double& pvalue)
+  {
+    if (!visit(0, m_items, 0.0)) return false;
+    pvalue = m_pvalue - 0.5 * m_tie;
+    return true;
+  }
+  
+private:
+  // Sums exp(constant - stat) over the 2 x 2 tables with the given marginals whose log factorial sum stat is at least
+  // extreme. Each table is fixed by its upper left cell x, and as the probabilities of x are unimodal the counted
+  // tables form its two tails. Both tails are walked outward from the mode by the ratio between neighboring
+  // probabilities, stopping once their terms no longer change the sum. When tie is given, the tables within
+  // 2 * TOLERANCE above extreme, those tied with the observed table, are also summed into it.
+  static double tails(const double* facts, double constant, double extreme, int row1, int row2, int col1,
+                      double* tie = NULL)
+  {
+    const int lo = (col1 > row2) ? col1 - row2 : 0;
+    const int hi = (row1 < col1) ? row1 : col1;
+    int mode = (int)(((double)row1 + 1.0) * ((double)col1 + 1.0) / ((double)row1 + row2 + 2.0));
+    if (mode < lo) mode = lo;
+    if (mode > hi) mode = hi;
+    
+    const double threshold = exp(constant - extreme);
+    const double tie_threshold = threshold * exp(-2.0 * TOLERANCE);
+    const double p_mode = exp(constant - facts[mode] - facts[row1 - mode] - facts[col1 - mode]
+                              - facts[row2 - col1 + mode]);
+    double sum = 0.0;
+    if (p_mode <= threshold) {
+      sum = p_mode;
+      if (tie && p_mode > tie_threshold) *tie += p_mode;
+    }
+    
+    double p = p_mode;
+    for (int x = mode; x > lo; x--) {
+      p *= ((double)x * (row2 - col1 + x)) / ((double)(row1 - x + 1) * (col1 - x + 1));
+      if (p <= threshold) {
+        sum += p;
+        if (tie && p > tie_threshold) *tie += p;
+        if (p <= sum * DBL_EPSILON) break;
+      }
+    }
+    p = p_mode;
+    for (int x = mode; x < hi; x++) {
+      p *= ((double)(row1 - x) * (col1 - x)) / ((double)(x + 1) * (row2 - col1 + x + 1));
+      if (p <= threshold) {
+        sum += p;
+        if (tie && p > tie_threshold) *tie += p;
+        if (p <= sum * DBL_EPSILON) break;
+      }
+    }
+    return sum;
+  }
+  
+  // Visits the partial first row that leaves items to place over the columns from col on, with stat as the log
+  // factorial sum of the cells placed so far
+  bool visit(int col, int items, double stat)
+  {
+    if (--m_budget < 0) return false;
+    
+    const int remaining = m_suffix_total[col];
+    if (col == m_ncol - 1) {
+      stat += m_facts[items] + m_facts[remaining - items];
+      if (stat >= m_extreme) {
+        const double p = exp(m_constant - stat);
+        m_pvalue += p;
+        if (stat < m_extreme + m_tie_band) m_tie += p;
+      }
+      return true;
+    }
+    if (col == m_ncol - 2) {
+      // The last two columns form a 2 x 2 table
+      m_pvalue += tails(m_facts, m_constant - stat, m_extreme - stat, items, remaining - items, m_cols[col],
+                        (m_tie_band > 0.0) ? &m_tie : NULL);
+      return true;
+    }
+    
+    // The remaining columns add at most the sum of their marginal log factorials, reached by filling whole columns.
+    // Subtrees summed in closed form must also lie beyond the tied band, so that their tables are never tied.
+    if (stat + m_suffix_facts[col] < m_extreme) return true;
+    if (stat + minimumRemaining(col, items) >= m_extreme + m_tie_band) {
+      m_pvalue += exp(m_constant - stat + m_facts[remaining] - m_facts[items] - m_facts[remaining - items]
+                      - m_suffix_facts[col]);
+      return true;
+    }
+    
+    const int later = m_suffix_total[col + 1];
+    const int lo = (items > later) ? items - later : 0;
+    const int hi = (items < m_cols[col]) ? items : m_cols[col];
+    for (int x = lo; x <= hi; x++) {
+      if (!visit(col + 1, items - x, stat + m_facts[x] + m_facts[m_cols[col] - x])) return false;
+    }
+    return true;
+  }
+  
+  // Lower bound on the log factorial sum of the columns from col on, given the items left for the first row. Each
+  // column is minimized separately against the multiplier that balances the items across columns in proportion to
+  // their size (the Lagrangian dual of the convex allocation problem).
+  double minimumRemaining(int col, int items) const
+  {
+    const int remaining = m_suffix_total[col];
+    if (items == 0 || items == remaining) return m_suffix_facts[col];
+    
+    const double share = (double)items / remaining;
+    const double multiplier = log((double)items / (remaining - items));
+    double bound = multiplier * items;
+    for (int j = col; j < m_ncol; j++) {
+      const int c = m_cols[j];
+      int x = (int)(c * share + 0.5);
+      
+      // The column term less multiplier * x is convex in x, step from the proportional share to its minimum
+      while (x < c && m_facts[x + 1] - m_facts[x] - (m_facts[c - x] - m_facts[c - x - 1]) < multiplier) x++;
+      while (x > 0 && m_facts[x] - m_facts[x - 1] - (m_facts[c - x + 1] - m_facts[c - x]) > multiplier) x--;
+      bound += m_facts[x] + m_facts[c - x] - multiplier * x;
+    }
+    return bound;
+  }
+};
+
+
+
 // Exported Function Definitions
 // -------------------------------------------------------------------------------------------------------------- 
 
-double Apto::Stat::FishersExact(const ContingencyTable& table)
+static double fishersExact(const Stat::ContingencyTable& table, bool mid_p)
 {
   if (table.MarginalTotal() == 0.0) return std::numeric_limits<double>::quiet_NaN();  // All elements are 0
   
-  FExact fe(table, TOLERANCE);
+  // Tables with two rows or two columns are summed directly, falling back to FExact should the network grow too large
+  const int nrow = table.NumRows(), ncol = table.NumCols();
+  if (nrow == 2 && ncol == 2) {
+    return FExactTwoRow::Calculate2x2(table.ElementAt(0, 0), table.ElementAt(0, 1), table.ElementAt(1, 0),
+                                      table.ElementAt(1, 1), mid_p);
+  }
+  if ((nrow == 2 && ncol <= TWO_ROW_MAX_COLS) || (ncol == 2 && nrow <= TWO_ROW_MAX_COLS)) {
+    FExactTwoRow network(table, mid_p);
+    double pvalue;
+    if (network.Calculate(pvalue)) return pvalue;
+  }
+  
+  FExact fe(table, TOLERANCE, mid_p);
 
-  // Use threaded calculate for larger tables
-  if (table.NumRows() * table.NumCols() > THREADING_THRESHOLD) return fe.ThreadedCalculate();
+  // Use threaded calculate for larger tables, when worker threads are available
+  if (table.NumRows() * table.NumCols() > THREADING_THRESHOLD && FExactWorkerPool::Instance().NumWorkers() > 0) {
+    return fe.ThreadedCalculate();
+  }
   
   return fe.Calculate();
 }
 
 
+static void fishersExact(const Array<Stat::ContingencyTable>& tables, Array<double>& pvalues, bool mid_p)
+{
+  pvalues.ResizeClear(tables.GetSize());
+  
+  // Large tables are calculated one after another, each spreading its path calculations across the worker pool
+  Array<int, Smart> small_tables;
+  for (int i = 0; i < tables.GetSize(); i++) {
+    if (tables[i].NumRows() * tables[i].NumCols() > THREADING_THRESHOLD) {
+      pvalues[i] = fishersExact(tables[i], mid_p);
+    } else {
+      small_tables.Push(i);
+    }
+  }
+  if (small_tables.GetSize() == 0) return;
+  
+  // Small tables are spread across the worker pool, with the calling thread working alongside
+  FExactWorkerPool& pool = FExactWorkerPool::Instance();
+  FExactWorkerPool::TaskGroup batch_group;
+  FExactBatch batch(tables, small_tables, pvalues, mid_p);
+  int helpers = (pool.NumWorkers() < small_tables.GetSize() - 1) ? pool.NumWorkers() : small_tables.GetSize() - 1;
+  for (int i = 0; i < helpers; i++) pool.Submit(&batch, batch_group);
+  batch.Process();
+  batch_group.Wait();
+}
+
+
+double Apto::Stat::FishersExact(const ContingencyTable& table)
+{
+  return fishersExact(table, false);
+}
+
+
+double Apto::Stat::FishersExactMidP(const ContingencyTable& table)
+{
+  return fishersExact(table, true);
+}
+
+
+void Apto::Stat::FishersExact(const Array<ContingencyTable>& tables, Array<double>& pvalues)
+{
+  fishersExact(tables, pvalues, false);
+}
+
+
+void Apto::Stat::FishersExactMidP(const Array<ContingencyTable>& tables, Array<double>& pvalues)
+{
+  fishersExact(tables, pvalues, true);
+}
+
+
+double Apto::Stat::FishersExact2x2(int n11, int n12, int n21, int n22)
+{
+  assert(n11 >= 0 && n12 >= 0 && n21 >= 0 && n22 >= 0);
+  if (n11 + n12 + n21 + n22 == 0) return std::numeric_limits<double>::quiet_NaN();  // All elements are 0
+  return FExactTwoRow::Calculate2x2(n11, n12, n21, n22);
+}
+
+
+void Apto::Stat::FishersExact2x2(const int* cells, double* pvalues, int count)
+{
+  // Size the shared log factorial table once, so the loop below is free of locks and allocation
+  int max_total = 0;
+  for (int i = 0; i < count; i++) {
+    const int* t = cells + 4 * i;
+    if (t[0] + t[1] + t[2] + t[3] > max_total) max_total = t[0] + t[1] + t[2] + t[3];
+  }
+  LogFactorials(max_total);
+  
+  for (int i = 0; i < count; i++) {
+    const int* t = cells + 4 * i;
+    pvalues[i] = FishersExact2x2(t[0], t[1], t[2], t[3]);
+  }
+}
+
+
+double Apto::Stat::FishersExactMonteCarlo(const ContingencyTable& table, Random& rng, double& std_error,
+                                          double confidence_width, int max_samples)
+{
+  assert(max_samples > 0);
+  
+  if (table.MarginalTotal() == 0) {  // All elements are 0
+    std_error = std::numeric_limits<double>::quiet_NaN();
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  
+  // Tables whose cell log factorials sum to at least that of the observed table are no more probable
+  const double* facts = LogFactorials(table.MarginalTotal());
+  double observed = 0.0;
+  for (int i = 0; i < table.NumRows(); i++) {
+    for (int j = 0; j < table.NumCols(); j++) observed += facts[table.ElementAt(i, j)];
+  }
+  const double extreme = observed - TOLERANCE;
+  
+  // Streams come from a generator of the same engine reseeded with a draw from rng, so that repeated calls with one
+  // generator sample independently
+  Random* parent = rng.CreateStream(0);
+  if (parent) parent->ResetSeed((int)(rng.GetUInt() & 0x7FFFFFFF));
+  Array<Random*> streams(MONTE_CARLO_STREAMS);
+  Array<FExactMonteCarlo*> samplers(MONTE_CARLO_STREAMS);
+  for (int s = 0; s < MONTE_CARLO_STREAMS; s++) {
+    streams[s] = (parent) ? parent->CreateStream(s) : NULL;
+    samplers[s] = new FExactMonteCarlo(table, facts, extreme, (streams[s]) ? streams[s] : &rng);
+  }
+  delete parent;
+  
+  // Engines without streams share the caller's generator, and so must sample on the calling thread
+  FExactWorkerPool& pool = FExactWorkerPool::Instance();
+  const bool parallel = (pool.NumWorkers() > 0 && streams[0] != NULL);
+  
+  int samples = 0;
+  int extreme_count = 0;
+  while (samples < max_samples) {
+    // Spread this round evenly over the streams, never exceeding max_samples in total
+    const int remaining = max_samples - samples;
+    for (int s = 0; s < MONTE_CARLO_STREAMS; s++) {
+      int quota = remaining / MONTE_CARLO_STREAMS + ((s < remaining % MONTE_CARLO_STREAMS) ? 1 : 0);
+      samplers[s]->SetQuota((quota < MONTE_CARLO_BLOCK) ? quota : MONTE_CARLO_BLOCK);
+    }
+    
+    if (parallel) {
+      FExactWorkerPool::TaskGroup round_group;
+      for (int s = 1; s < MONTE_CARLO_STREAMS; s++) pool.Submit(samplers[s], round_group);
+      samplers[0]->Process();
+      round_group.Wait();
+    } else {
+      for (int s = 0; s < MONTE_CARLO_STREAMS; s++) samplers[s]->Process();
+    }
+    
+    for (int s = 0; s < MONTE_CARLO_STREAMS; s++) extreme_count += samplers[s]->ExtremeCount();
+    const int round_size = MONTE_CARLO_STREAMS * MONTE_CARLO_BLOCK;
+    samples += (remaining < round_size) ? remaining : round_size;
+    
+    // Standard error from the count adjusted by one success and one failure, so it never collapses to zero
+    const double adjusted = (extreme_count + 1.0) / (samples + 2.0);
+    std_error = sqrt(adjusted * (1.0 - adjusted) / samples);
+    if (2.0 * MONTE_CARLO_Z * std_error <= confidence_width) break;
+  }
+  
+  for (int s = 0; s < MONTE_CARLO_STREAMS; s++) {
+    delete samplers[s];
+    delete streams[s];
+  }
+  
+  return (double)extreme_count / samples;
+}
+
+
 
 // FExact Constructor and Support Methods
 // -------------------------------------------------------------------------------------------------------------- 
 
-FExact::FExact(const Stat::ContingencyTable& table, double tolerance)
+FExact::FExact(const Stat::ContingencyTable& table, double tolerance, bool mid_p)
   : m_tolerance(tolerance)
-  , m_facts(table.MarginalTotal() + 1)
+  , m_facts(Stat::LogFactorials(table.MarginalTotal()))
   , m_pvalue(0.0)
+  , m_tie_band((mid_p) ? 2.0 * tolerance : 0.0)
+  , m_tie(0.0)
+  , m_path_calc(NULL)
+  , m_path_group(NULL)
 {
   // Store table marginals for use in calculation
   if (table.NumRows() > table.NumCols()) {
@@ -529,29 +1322,13 @@ FExact::FExact(const Stat::ContingencyTable& table, double tolerance)
   QSort(m_col_marginals);
 
   
-  // Set up key multipliers
-  m_key_multipliers.Resize(m_row_marginals.GetSize());
-  m_key_multipliers[0] = 1;
-  for (int i = 1; i < m_row_marginals.GetSize(); i++)
-    m_key_multipliers[i] = m_key_multipliers[i - 1] * (m_row_marginals[i - 1] + 1);
+  // Set up node keys, each sorted remaining row marginal is bounded by the matching sorted table row marginal
+  MarginalArray key_radix(m_row_marginals.GetSize());
+  for (int i = 0; i < m_row_marginals.GetSize(); i++) key_radix[i] = m_row_marginals[i] + 1;
+  m_keys.Setup(key_radix);
   
 
-  // Ensure that the maximum key will fit within an integer
-  assert((m_row_marginals[m_row_marginals.GetSize() - 2] + 1) <=
-         (std::numeric_limits<int>::max() / m_key_multipliers[m_row_marginals.GetSize() - 2]));
-  
-
-  // Pre-calculate log factorials
   const int marginal_total = table.MarginalTotal();
-  m_facts[0] = 0.0;
-  m_facts[1] = 0.0;
-  if (marginal_total > 1) {
-    m_facts[2] = log(2.0);
-    for (int i = 3; i <= marginal_total; i++) {
-      m_facts[i] = m_facts[i - 1] + log((double)i);
-      if (++i <= marginal_total)  m_facts[i] = m_facts[i - 1] + m_facts[2] + m_facts[i / 2] - m_facts[i / 2 - 1];
-    }
-  }
   
   
   // Calculate Observed Path Numerator
@@ -600,12 +1377,14 @@ inline double FExact::logMultinomial(int numerator, const MarginalArray::Slice&
 
 double FExact::Calculate()
 {
-  NodeHashTable nht[2];
+  StageNodeTable nht[2];
   PathExtremesHashTable path_extremes;
   
   int k = m_col_marginals.GetSize();
-  NodePtr cur_node(new FExactNode(0));
-  cur_node->past_entries.Push(PastPathLength(0));
+  int cur_node;
+  nht[(k + 1) & 0x1].Find(m_keys.Key(m_row_marginals), cur_node);
+  nht[(k + 1) & 0x1].AddPath(cur_node, PastPathLength(0));
+  nht[(k + 1) & 0x1].Pop();
   
   MarginalArray row_diff(m_row_marginals.GetSize());
   MarginalArray irn(m_row_marginals.GetSize());
@@ -648,14 +1427,13 @@ double FExact::Calculate()
         double ddf = logMultinomial(m_col_marginals[kb], row_diff);
         double drn = logMultinomial(ntot, sub_rows) - m_den_observed_path + ddf;
         
-        int kval = 0;
+        FExactKey kval = 0;
         int path_idx = -1;
         double obs2, obs3;
         
         if (k > 2) {
           // compute hash table key for current table
-          kval = irn[0] + irn[1] * m_key_multipliers[1];
-          for (int i = 2; i < irn.GetSize(); i++) kval += irn[i] * m_key_multipliers[i];
+          kval = m_keys.Key(irn);
 
           if (!path_extremes.Find(kval, path_idx)) {
             path_extremes[path_idx].longest_path = 1.0;
@@ -682,27 +1460,24 @@ double FExact::Calculate()
           obs3 = obs2;
         }
         
-        handlePastPaths(cur_node, obs2, obs3, ddf, drn, kval, nht[k & 0x1]);
+        handlePastPaths(nht[(k + 1) & 0x1], cur_node, obs2, obs3, ddf, drn, kval, nht[k & 0x1]);
       } while (generateNewDaughter(kmax, m_row_marginals, row_diff, kd, ks));
     }
     
     do {
       cur_node = nht[(k + 1) & 0x1].Pop();
-      if (!cur_node) {
+      if (cur_node < 0) {
+        // Stage drained, reset it in bulk to receive the nodes of the stage after next
+        nht[(k + 1) & 0x1].Clear();
         k--;
 //        printf("k = %d\n", k);
         path_extremes.ClearTable();
-        if (k < 2) return m_pvalue;
+        if (k < 2) return m_pvalue - 0.5 * m_tie;
       }
-    } while (!cur_node);
+    } while (cur_node < 0);
     
     // Unpack node row marginals from key
-    int kval = cur_node->key;
-    for (int i = m_row_marginals.GetSize() - 1; i > 0; i--) {
-      m_row_marginals[i] = kval / m_key_multipliers[i];
-      kval -= m_row_marginals[i] * m_key_multipliers[i];
-    }
-    m_row_marginals[0] = kval;
+    m_keys.Unpack(nht[(k + 1) & 0x1][cur_node].key, m_row_marginals);
   }
   
   return m_pvalue;
@@ -718,26 +1493,23 @@ double FExact::ThreadedCalculate()
   int k = m_col_marginals.GetSize();
 
   // Setup Multi-Stage Data Structures
-  m_nht.Resize(k + 1);
   m_pending_path_nodes.Resize(k + 1);
   m_path_extremes.Resize(k + 1);
   m_pending_path_extremes.Resize(k + 1);
   m_completed_path_extremes.Resize(k + 1);
   
   
-  // Setup Path Calculation Worker Thread
-  Array<PathExtremesCalc*> path_calcs(Platform::AvailableCPUs());
-  for (int i = 0; i < path_calcs.GetSize(); i++) {
-    path_calcs[i] = new PathExtremesCalc(this);
-    path_calcs[i]->Start();
-  }
+  // Path extremes are calculated on the shared worker pool, handleNode submits one task per queued calculation
+  PathExtremesCalc path_calc(this);
+  FExactWorkerPool::TaskGroup path_group;
+  m_path_calc = &path_calc;
+  m_path_group = &path_group;
   
   
   // Single Stage Support Variables
-  int kval = m_row_marginals[0] + m_row_marginals[1] * m_key_multipliers[1];
-  for (int i = 2; i < m_row_marginals.GetSize(); i++) kval += m_row_marginals[i] * m_key_multipliers[i];
-  NodePtr cur_node(new FExactNode(kval));
-  cur_node->past_entries.Push(PastPathLength(0));
+  int cur_node;
+  m_nht[k & 0x1].Find(m_keys.Key(m_row_marginals), cur_node);
+  m_nht[k & 0x1].AddPath(cur_node, PastPathLength(0));
 
 
   handleNode(k, cur_node);
@@ -774,9 +1546,8 @@ double FExact::ThreadedCalculate()
                 obs3 = p.obs2 - m_path_extremes[k][path_idx].longest_path;
                 obs2 = p.obs2 - m_path_extremes[k][path_idx].shortest_path;
               }
-              cur_node = handlePastPaths(p.node, obs2, obs3, p.ddf, p.drn, p.kval, m_nht[k  - 1]);
-              p.node = NodePtr(NULL);
-              if (cur_node) handleNode(k - 1, cur_node);
+              cur_node = handlePastPaths(m_nht[k & 0x1], p.node, obs2, obs3, p.ddf, p.drn, p.kval, m_nht[(k - 1) & 0x1]);
+              if (cur_node >= 0) handleNode(k - 1, cur_node);
               p.handled = true;
             }
           }
@@ -806,29 +1577,32 @@ double FExact::ThreadedCalculate()
           obs3 = p.obs2 - m_path_extremes[k][path_idx].longest_path;
           obs2 = p.obs2 - m_path_extremes[k][path_idx].shortest_path;
         }
-        cur_node = handlePastPaths(p.node, obs2, obs3, p.ddf, p.drn, p.kval, m_nht[k  - 1]);
-        p.node = NodePtr(NULL);
-        if (cur_node) handleNode(k - 1, cur_node);
+        cur_node = handlePastPaths(m_nht[k & 0x1], p.node, obs2, obs3, p.ddf, p.drn, p.kval, m_nht[(k - 1) & 0x1]);
+        if (cur_node >= 0) handleNode(k - 1, cur_node);
       }
       m_pending_path_nodes[k].Resize(0);
     }
+    
+    // Stage complete, reset it in bulk to receive the nodes of stage k - 2
+    m_nht[k & 0x1].Clear();
   }
   
-  for (int i = 0; i < path_calcs.GetSize(); i++) path_calcs[i]->SetFinished();
-  m_path_extremes_cond.Broadcast();
-  for (int i = 0; i < path_calcs.GetSize(); i++) path_calcs[i]->Join();
+  // Every calculation has been consumed, wait for the tasks to return before releasing them
+  path_group.Wait();
+  m_path_calc = NULL;
+  m_path_group = NULL;
   
-  return m_pvalue;
+  return m_pvalue - 0.5 * m_tie;
 }
 
 
-void FExact::handleNode(int k, NodePtr cur_node)
+void FExact::handleNode(int k, int cur_node)
 {
   MarginalArray row_marginals(m_row_marginals.GetSize());
   MarginalArray row_diff(row_marginals.GetSize());
   MarginalArray irn(row_marginals.GetSize());
   
-  unpackMarginals(cur_node->key, row_marginals);
+  m_keys.Unpack(m_nht[k & 0x1][cur_node].key, row_marginals);
 
   int kb = m_col_marginals.GetSize() - k;
   int ks = -1;
@@ -858,14 +1632,13 @@ void FExact::handleNode(int k, NodePtr cur_node)
     double ddf = logMultinomial(m_col_marginals[kb], row_diff);
     double drn = logMultinomial(ntot, sub_rows) - m_den_observed_path + ddf;
     
-    int kval = 0;
+    FExactKey kval = 0;
     int path_idx = -1;
     double obs2;
     
     if (k > 2) {
       // compute hash table key for current table
-      kval = irn[0] + irn[1] * m_key_multipliers[1];
-      for (int i = 2; i < irn.GetSize(); i++) kval += irn[i] * m_key_multipliers[i];
+      kval = m_keys.Key(irn);
       
       obs2 = m_observed_path - m_facts[m_col_marginals[kb + 1]] - m_facts[m_col_marginals[kb + 2]] - ddf;
       for (int i = 3; i <= (k - 1); i++) obs2 -= m_facts[m_col_marginals[kb + i]];
@@ -891,7 +1664,7 @@ void FExact::handleNode(int k, NodePtr cur_node)
           }
         }
         m_path_extremes_mutex.Unlock();
-        m_path_extremes_cond.Signal();
+        FExactWorkerPool::Instance().Submit(m_path_calc, *m_path_group);
       }
       
       // Push node onto pending stack
@@ -912,52 +1685,45 @@ void FExact::handleNode(int k, NodePtr cur_node)
 // Path Extremes Threading Methods
 // -------------------------------------------------------------------------------------------------------------- 
 
-void FExact::PathExtremesCalc::Run()
+void FExact::PathExtremesCalc::Process()
 {
-  while (true) {
-    int k;
-    int path_idx;
-
-    m_fexact->m_path_extremes_mutex.Lock();
-    {
-      while (m_fexact->m_path_extremes_queue.GetSize() == 0 && m_run) {
-        m_fexact->m_path_extremes_cond.Wait(m_fexact->m_path_extremes_mutex);
-      }
-      if (!m_run) {
-        m_fexact->m_path_extremes_mutex.Unlock();
-        return;
-      }
-      k = m_fexact->m_path_extremes_queue.Pop();      
+  int k;
+  int path_idx = -1;
+  
+  m_fexact->m_path_extremes_mutex.Lock();
+  {
+    if (m_fexact->m_path_extremes_queue.GetSize()) {
+      k = m_fexact->m_path_extremes_queue.Pop();
       path_idx = m_fexact->m_pending_path_extremes[k].Pop();
     }
-    m_fexact->m_path_extremes_mutex.Unlock();
-    
-    if (path_idx < 0) continue;
-    
-    PendingPathExtremes& p = m_fexact->m_pending_path_extremes[k][path_idx];
-    
-    double longest_path = m_fexact->longestPath(p.rows.Range(0, p.rows.GetSize() - 1), p.cols.Range(0, p.cols.GetSize() - 1), p.ntot);
-    if (longest_path > 0.0) longest_path = 0.0;
-    
-    double dspt = m_fexact->m_observed_path - p.obs2 - p.ddf;
-    double shortest_path = dspt;
-    m_fexact->shortestPath(p.rows.Range(0, p.rows.GetSize() - 1), p.cols.Range(0, p.cols.GetSize() - 1), shortest_path);
-    shortest_path -= dspt;
-    if (shortest_path > 0.0) shortest_path = 0.0;
+  }
+  m_fexact->m_path_extremes_mutex.Unlock();
+  
+  if (path_idx < 0) return;
+  
+  PendingPathExtremes& p = m_fexact->m_pending_path_extremes[k][path_idx];
+  
+  double longest_path = m_fexact->longestPath(p.rows.Range(0, p.rows.GetSize() - 1), p.cols.Range(0, p.cols.GetSize() - 1), p.ntot);
+  if (longest_path > 0.0) longest_path = 0.0;
+  
+  double dspt = m_fexact->m_observed_path - p.obs2 - p.ddf;
+  double shortest_path = dspt;
+  m_fexact->shortestPath(p.rows.Range(0, p.rows.GetSize() - 1), p.cols.Range(0, p.cols.GetSize() - 1), shortest_path);
+  shortest_path -= dspt;
+  if (shortest_path > 0.0) shortest_path = 0.0;
+  
+  m_fexact->m_path_extremes_mutex.Lock();
+  {
+    // Record completed calculation
+    int completed_idx = m_fexact->m_completed_path_extremes[k].GetSize();
+    m_fexact->m_completed_path_extremes[k].Resize(completed_idx + 1);
+    m_fexact->m_completed_path_extremes[k][completed_idx].Set(p.key, longest_path, shortest_path);
     
-    m_fexact->m_path_extremes_mutex.Lock();
-    {
-      // Record completed calculation
-      int completed_idx = m_fexact->m_completed_path_extremes[k].GetSize();
-      m_fexact->m_completed_path_extremes[k].Resize(completed_idx + 1);
-      m_fexact->m_completed_path_extremes[k][completed_idx].Set(p.key, longest_path, shortest_path);
-      
-      // Clear out the pending record
-      m_fexact->m_pending_path_extremes[k].Remove(path_idx);
-    }
-    m_fexact->m_path_extremes_mutex.Unlock();
-    m_fexact->m_path_extremes_cond_complete.Signal();
+    // Clear out the pending record
+    m_fexact->m_pending_path_extremes[k].Remove(path_idx);
   }
+  m_fexact->m_path_extremes_mutex.Unlock();
+  m_fexact->m_path_extremes_cond_complete.Signal();
 }
 
 
@@ -1048,26 +1814,31 @@ bool FExact::generateNewDaughter(int kmax, const MarginalArray& row_marginals, M
 }
 
 
-FExact::NodePtr FExact::handlePastPaths(NodePtr& cur_node, double obs2, double obs3, double ddf, double drn, int kval,
-                             NodeHashTable& nht)
+int FExact::handlePastPaths(StageNodeTable& nodes, int cur_node, double obs2, double obs3, double ddf, double drn,
+                            FExactKey kval, StageNodeTable& nht)
 {
-  NodePtr new_node(NULL);
-  for (int i = 0; i < cur_node->past_entries.GetSize(); i++) {
-    double past_path = cur_node->past_entries[i].value;
-    int path_freq = cur_node->past_entries[i].observed;
-    if (past_path <= obs3) {
+  int new_node = -1;
+  for (int i = nodes[cur_node].first_path; i >= 0; i = nodes.Path(i).next) {
+    double past_path = nodes.Path(i).value;
+    int path_freq = nodes.Path(i).observed;
+    if (past_path <= obs3 - m_tie_band) {
       // Path shorter than longest path, add to the pvalue and continue
       m_pvalue += (double)(path_freq) * exp(past_path + drn);
+    } else if (past_path <= obs3 && past_path >= obs2 - m_tie_band) {
+      // Every completion of the path is tied with the observed table
+      const double tied = (double)(path_freq) * exp(past_path + drn);
+      m_pvalue += tied;
+      m_tie += tied;
     } else if (past_path < obs2) {
       int nht_idx;
       double new_path = past_path + ddf;
       if (nht.Find(kval, nht_idx)) {
         // Existing Node was found            
-        recordPath(new_path, path_freq, nht[nht_idx].past_entries);
+        recordPath(new_path, path_freq, nht, nht_idx);
       } else {
         // New Node added, insert this observed path
-        new_node = nht.Get(nht_idx);
-        new_node->past_entries.Push(PastPathLength(new_path, path_freq));
+        new_node = nht_idx;
+        nht.AddPath(new_node, PastPathLength(new_path, path_freq));
       }
     }
   }
@@ -1075,56 +1846,45 @@ FExact::NodePtr FExact::handlePastPaths(NodePtr& cur_node, double obs2, double o
 }
 
 
-void FExact::recordPath(double path_length, int path_freq, Array<PastPathLength, Smart>& past_entries)
+void FExact::recordPath(double path_length, int path_freq, StageNodeTable& nht, int node)
 {
   // Search for past path within m_tolerance and add observed frequency to it
   double test1 = path_length - m_tolerance;
   double test2 = path_length + m_tolerance;
   
-  int j = 0;
-  int old_j = 0;
+  int j = nht[node].first_path;
+  int old_j = j;
   while (true) {
-    double test_path = past_entries[j].value;
+    double test_path = nht.Path(j).value;
     if (test_path < test1) {
       old_j = j;
-      j = past_entries[j].next_left;
+      j = nht.Path(j).next_left;
       if (j >= 0) continue;
     } else if (test_path > test2) {
       old_j = j;
-      j = past_entries[j].next_right;
+      j = nht.Path(j).next_right;
       if (j >= 0) continue;
     } else {
-      past_entries[j].observed += path_freq;
+      nht.Path(j).observed += path_freq;
       return;
     }
     break;
   }
   
   // If no path within m_tolerance is found, add new past path length to the node
-  int new_idx = past_entries.GetSize();
-  past_entries.Push(PastPathLength(path_length, path_freq)); 
+  int new_idx = nht.AddPath(node, PastPathLength(path_length, path_freq));
   
-  double test_path = past_entries[old_j].value;
+  double test_path = nht.Path(old_j).value;
   if (test_path < test1) {
-    past_entries[old_j].next_left = new_idx;
+    nht.Path(old_j).next_left = new_idx;
   } else if (test_path > test2) {
-    past_entries[old_j].next_right = new_idx;
+    nht.Path(old_j).next_right = new_idx;
   } else {
     assert(false);
   }  
 }
 
 
-void FExact::unpackMarginals(int key, MarginalArray& row_marginals)
-{
-  for (int i = row_marginals.GetSize() - 1; i > 0; i--) {
-    row_marginals[i] = key / m_key_multipliers[i];
-    key -= row_marginals[i] * m_key_multipliers[i];
-  }
-  row_marginals[0] = key;
-}
-
-
 
 // FExact Longest Path Methods
 // -------------------------------------------------------------------------------------------------------------- 
@@ -1134,19 +1894,19 @@ double FExact::longestPath(const MarginalArray::Slice& row_marginals, const Marg
   class ValueHashTable
   {
   private:
-    Array<Pair<int, double> >* m_table;
+    Array<Pair<FExactKey, double> >* m_table;
     Array<int> m_stack;
     int m_entry_count;
     
   public:
-    inline ValueHashTable(int size = 200) : m_table(new Array<Pair<int, double> >(size)), m_stack(size) { ClearTable(); }
+    inline ValueHashTable(int size = 200) : m_table(new Array<Pair<FExactKey, double> >(size)), m_stack(size) { ClearTable(); }
     inline ~ValueHashTable() { delete m_table; }
     
     int GetEntryCount() const { return m_entry_count; }
     
-    bool Find(int key, int& idx)
+    bool Find(FExactKey key, int& idx)
     {
-      int init = key % m_table->GetSize();
+      int init = (int)(key % m_table->GetSize());
       idx = init;
       for (; idx < m_table->GetSize(); idx++) {
         if ((*m_table)[idx].Value1() < 0) {
@@ -1174,9 +1934,9 @@ double FExact::longestPath(const MarginalArray::Slice& row_marginals, const Marg
     
     inline double& operator[](int idx) { return (*m_table)[idx].Value2(); }
     
-    Pair<int, double> Pop()
+    Pair<FExactKey, double> Pop()
     {
-      Pair<int, double> tmp = (*m_table)[m_stack[--m_entry_count]];
+      Pair<FExactKey, double> tmp = (*m_table)[m_stack[--m_entry_count]];
       (*m_table)[m_stack[m_entry_count]].Value1() = -1;
       return tmp;
     }
@@ -1188,10 +1948,10 @@ double FExact::longestPath(const MarginalArray::Slice& row_marginals, const Marg
     }
     
   private:
-    void Rehash(int key, int& idx)
+    void Rehash(FExactKey key, int& idx)
     {
-      Array<Pair<int, double> >* old_table = m_table;
-      m_table = new Array<Pair<int, double> >(old_table->GetSize() * 2);
+      Array<Pair<FExactKey, double> >* old_table = m_table;
+      m_table = new Array<Pair<FExactKey, double> >(old_table->GetSize() * 2);
       for (int i = 0; i < m_table->GetSize(); i++) (*m_table)[i].Value1() = -1;
       m_stack.Resize(old_table->GetSize() * 2);
       for (int i = 0; i < old_table->GetSize(); i++) {
@@ -1220,7 +1980,7 @@ double FExact::longestPath(const MarginalArray::Slice& row_marginals, const Marg
   
   // 2 x 2
   if (row_marginals.GetSize() == 2 && col_marginals.GetSize() == 2) {
-    int n11 = (row_marginals[0] + 1) * (col_marginals[0] + 1) / (marginal_total + 2);
+    int n11 = (int)((int64_t)(row_marginals[0] + 1) * (col_marginals[0] + 1) / (marginal_total + 2));
     int n12 = row_marginals[0] - n11;
     return -m_facts[n11] - m_facts[n12] - m_facts[col_marginals[0] - n11] - m_facts[col_marginals[1] - n12];
   }
@@ -1266,6 +2026,12 @@ double FExact::longestPath(const MarginalArray::Slice& row_marginals, const Marg
   int nc1s = lcol.GetSize() - 2;
   int kyy = lcol[lcol.GetSize() - 1] + 1;
   
+  // Column marginal keys, every sorted column digit is bounded by the largest column marginal
+  FExactKeyMap value_keys;
+  MarginalArray key_radix(lcol.GetSize());
+  key_radix.SetAll(kyy);
+  value_keys.Setup(key_radix);
+  
   Array<int> lb(lrow.GetSize());
   Array<int> nu(lrow.GetSize());
   Array<int> nr(lrow.GetSize());
@@ -1290,16 +2056,11 @@ double FExact::longestPath(const MarginalArray::Slice& row_marginals, const Marg
           if (lev == 0) {
             do {
               if (vht[(active_vht) ? 0 : 1].GetEntryCount()) {
-                Pair<int, double> entry = vht[(active_vht) ? 0 : 1].Pop();
+                Pair<FExactKey, double> entry = vht[(active_vht) ? 0 : 1].Pop();
                 val = entry.Value2();
-                int key = entry.Value1();
                 
                 // Compute Marginals
-                for (int i = lcol.GetSize() - 1; i > 0; i--) {
-                  lcol[i] = key % kyy;
-                  key = key / kyy;
-                }
-                lcol[0] = key;
+                value_keys.Unpack(entry.Value1(), lcol);
                 
                 // Set up nt array
                 nt[0] = ntot - lcol[0];
@@ -1350,8 +2111,8 @@ double FExact::longestPath(const MarginalArray::Slice& row_marginals, const Marg
         lev++;
         int nc1 = lcol.GetSize() - lev - 1;
         int nct = lcol[lev];
-        lb[lev] = (int)((double)((nrt + 1) * (nct + 1)) / (double)(nn1 + nr1 * nc1 + 1) - m_tolerance);
-        nu[lev] = (int)((double)((nrt + nc1) * (nct + nr1)) / (double)(nn1 + nr1 + nc1) - lb[lev] + 1);
+        lb[lev] = (int)(((double)(nrt + 1) * (nct + 1)) / (double)(nn1 + nr1 * nc1 + 1) - m_tolerance);
+        nu[lev] = (int)(((double)(nrt + nc1) * (nct + nr1)) / (double)(nn1 + nr1 + nc1) - lb[lev] + 1);
         nr[lev] = nrt - lb[lev];
       }
       alen[lcol.GetSize()] = alen[lev + 1] + m_facts[nr[lev]];
@@ -1366,7 +2127,7 @@ double FExact::longestPath(const MarginalArray::Slice& row_marginals, const Marg
         int nn1 = ntot - lrow[0] + 2;
         int ic1 = lcol[0] - lb[0];
         int ic2 = lcol[1] - lb[1];
-        int n11 = (lrow[1] + 1) * (ic1 + 1) / nn1;
+        int n11 = (int)((int64_t)(lrow[1] + 1) * (ic1 + 1) / nn1);
         int n12 = lrow[1] - n11;
         v += m_facts[n11] + m_facts[n12] + m_facts[ic1 - n11] + m_facts[ic2 - n12];
         if (v < vmn)
@@ -1382,8 +2143,7 @@ double FExact::longestPath(const MarginalArray::Slice& row_marginals, const Marg
         }
         
         // Compute hash value
-        int key = it[0] * kyy + it[1];
-        for (int i = 2; i < lcol.GetSize(); i++) key = it[i] + key * kyy;
+        FExactKey key = value_keys.Key(it);
         
         // Put onto stack (or update stack entry as necessary)
         int t_idx;
@@ -0,0 +1,118 @@
+/*
+ *  LogFactorial.cc
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#include "apto/stat/LogFactorial.h"
+
+#include "apto/core/Mutex.h"
+
+#include <atomic>
+#include <cassert>
+#include <cmath>
+
+
+// Internal Definitions
+// --------------------------------------------------------------------------------------------------------------
+
+static const int MIN_TABLE_SIZE = 1024;
+
+struct LogFactorialTable
+{
+  int size;
+  double* values;
+  LogFactorialTable* previous;  // outgrown tables are kept for readers that still hold them
+};
+
+static std::atomic<LogFactorialTable*> s_current(NULL);
+
+static Apto::Mutex& growMutex()
+{
+  static Apto::Mutex grow_mutex;
+  return grow_mutex;
+}
+
+static struct LogFactorialCleanup
+{
+  ~LogFactorialCleanup()
+  {
+    LogFactorialTable* table = s_current.exchange(NULL);
+    while (table) {
+      LogFactorialTable* previous = table->previous;
+      delete [] table->values;
+      delete table;
+      table = previous;
+    }
+  }
+} s_cleanup;
+
+
+
+// Exported Function Definitions
+// --------------------------------------------------------------------------------------------------------------
+
+const double* Apto::Stat::LogFactorials(int n)
+{
+  assert(n >= 0);
+  
+  LogFactorialTable* table = s_current.load(std::memory_order_acquire);
+  if (table && table->size > n) return table->values;
+  
+  Apto::MutexAutoLock lock(growMutex());
+  
+  // Another thread may have grown the table while this one waited
+  table = s_current.load(std::memory_order_acquire);
+  if (table && table->size > n) return table->values;
+  
+  int size = (table) ? table->size * 2 : MIN_TABLE_SIZE;
+  if (size <= n) size = n + 1;
+  
+  LogFactorialTable* grown = new LogFactorialTable;
+  grown->size = size;
+  grown->values = new double[size];
+  grown->previous = table;
+  
+  // Extend from the existing entries, halving even arguments to save a log() call per pair of entries
+  int first = 3;
+  if (table) {
+    for (int i = 0; i < table->size; i++) grown->values[i] = table->values[i];
+    first = table->size;
+  } else {
+    grown->values[0] = 0.0;
+    grown->values[1] = 0.0;
+    grown->values[2] = log(2.0);
+  }
+  double* facts = grown->values;
+  for (int i = first; i < size; i++) {
+    if (i & 0x1) facts[i] = facts[i - 1] + log((double)i);
+    else facts[i] = facts[i - 1] + facts[2] + facts[i / 2] - facts[i / 2 - 1];
+  }
+  
+  s_current.store(grown, std::memory_order_release);
+  return grown->values;
+}
@@ -0,0 +1,436 @@
+/*
+ *  unittests/core/Random.cc
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#include "apto/core/Random.h"
+
+#include "apto/core/Array.h"
+#include "apto/core/SmartPtr.h"
+#include "apto/rng/AvidaRNG.h"
+#include "apto/rng/AvidaRNGLanes.h"
+#include "apto/rng/PCG64.h"
+#include "apto/rng/Philox.h"
+#include "apto/rng/SplitMix64.h"
+#include "apto/rng/Xoshiro256StarStar.h"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <typeinfo>
+
+
+// Chi-square statistic of samples binned over [low, high), with one extra bin on each side for the tails. Bins that
+// should be empty must be, or the statistic is infinite.
+template <class Sampler, class CDF>
+static double BinnedChiSquare(Sampler sample, CDF cdf, double low, double high, int bins, int draws)
+{
+  Apto::Array<int> counts(bins + 2);
+  counts.SetAll(0);
+  double width = (high - low) / bins;
+  for (int i = 0; i < draws; i++) {
+    double value = sample();
+    int bin = (value < low) ? 0 : ((value >= high) ? bins + 1 : 1 + static_cast<int>((value - low) / width));
+    if (bin > bins) bin = bins + 1;
+    counts[bin]++;
+  }
+  
+  double chi_square = 0.0;
+  for (int b = 0; b < bins + 2; b++) {
+    double lower = (b == 0) ? -HUGE_VAL : low + (b - 1) * width;
+    double upper = (b == bins + 1) ? HUGE_VAL : low + b * width;
+    double expected = draws * (cdf(upper) - cdf(lower));
+    if (expected == 0.0) {
+      if (counts[b]) return HUGE_VAL;
+      continue;
+    }
+    double diff = counts[b] - expected;
+    chi_square += diff * diff / expected;
+  }
+  return chi_square;
+}
+
+static double NormalCDF(double x) { return (x == -HUGE_VAL) ? 0.0 : ((x == HUGE_VAL) ? 1.0 : 0.5 * erfc(-x / sqrt(2.0))); }
+static double ExponentialCDF(double x) { return (x <= 0.0) ? 0.0 : ((x == HUGE_VAL) ? 1.0 : 1.0 - exp(-x)); }
+
+struct NormalSampler
+{
+  Apto::Random& rng;
+  NormalSampler(Apto::Random& in_rng) : rng(in_rng) { ; }
+  double operator()() { return rng.GetRandNormal(); }
+};
+
+struct ExponentialSampler
+{
+  Apto::Random& rng;
+  ExponentialSampler(Apto::Random& in_rng) : rng(in_rng) { ; }
+  double operator()() { return rng.GetRandExponential(); }
+};
+
+
+// Minimal generator implementing only the required interface, as an out of tree subclass would
+class CounterRandom : public Apto::Random
+{
+private:
+  unsigned int m_count;
+  
+public:
+  CounterRandom() : Apto::Random(0, 1), m_count(0) { ; }
+  
+protected:
+  void reset() { m_count = 0; }
+  unsigned int getNext() { return m_count++; }
+};
+
+
+TEST(CoreRandom, CreateStream) {
+  CounterRandom counter;
+  EXPECT_EQ(0u, counter.GetUInt());
+  EXPECT_EQ(1u, counter.GetUInt());
+  EXPECT_EQ(NULL, counter.CreateStream(0));
+}
+
+
+// Streams created from a stream must not repeat the parent's other streams, must be reproducible, and must survive
+// checkpointing the stream they were created from
+template <class Engine>
+static void CheckNestedStreams()
+{
+  SCOPED_TRACE(typeid(Engine).name());
+  
+  Engine parent(42);
+  Apto::SmartPtr<Apto::Random> stream_0(parent.CreateStream(0));
+  Apto::SmartPtr<Apto::Random> stream_1(parent.CreateStream(1));
+  Apto::SmartPtr<Apto::Random> nested_0(stream_1->CreateStream(0));
+  Apto::SmartPtr<Apto::Random> nested_1(stream_1->CreateStream(1));
+  Apto::SmartPtr<Apto::Random> nested_again(Apto::SmartPtr<Apto::Random>(parent.CreateStream(1))->CreateStream(0));
+  
+  Apto::Array<unsigned char> state(stream_1->StateSize());
+  stream_1->SaveState(&state[0], state.GetSize());
+  Engine restored(1);
+  EXPECT_TRUE(restored.RestoreState(&state[0], state.GetSize()));
+  Apto::SmartPtr<Apto::Random> nested_restored(restored.CreateStream(0));
+  
+  for (int i = 0; i < 10; i++) {
+    unsigned int value = nested_0->GetUInt();
+    EXPECT_NE(stream_0->GetUInt(), value);
+    EXPECT_NE(stream_1->GetUInt(), value);
+    EXPECT_NE(nested_1->GetUInt(), value);
+    EXPECT_EQ(value, nested_again->GetUInt());
+    EXPECT_EQ(value, nested_restored->GetUInt());
+  }
+}
+
+
+TEST(CoreRandom, NestedStreams) {
+  CheckNestedStreams<Apto::RNG::AvidaRNG>();
+  CheckNestedStreams<Apto::RNG::AvidaRNGLanes>();
+  CheckNestedStreams<Apto::RNG::PCG64>();
+  CheckNestedStreams<Apto::RNG::SplitMix64>();
+  CheckNestedStreams<Apto::RNG::Xoshiro256StarStar>();
+}
+
+
+TEST(CoreRandom, State) {
+  // Generators without checkpoint support report no state and refuse to save or restore
+  CounterRandom counter;
+  unsigned char buffer[64];
+  EXPECT_EQ(0, counter.StateSize());
+  EXPECT_FALSE(counter.SaveState(buffer, sizeof(buffer)));
+  EXPECT_FALSE(counter.RestoreState(buffer, sizeof(buffer)));
+  
+  // Method selections are part of the checkpoint
+  Apto::RNG::AvidaRNG avida(5);
+  avida.SetNormalMethod(Apto::Random::NORMAL_ZIGGURAT);
+  avida.SetDiscreteMethod(Apto::Random::DISCRETE_EXACT);
+  Apto::Array<unsigned char> state(avida.StateSize());
+  ASSERT_TRUE(avida.SaveState(&state[0], state.GetSize()));
+  Apto::RNG::AvidaRNG restored(6);
+  ASSERT_TRUE(restored.RestoreState(&state[0], state.GetSize()));
+  EXPECT_EQ(Apto::Random::NORMAL_ZIGGURAT, restored.GetNormalMethod());
+  EXPECT_EQ(Apto::Random::DISCRETE_EXACT, restored.GetDiscreteMethod());
+  EXPECT_EQ(avida.GetRandBinomial(1000, 0.3), restored.GetRandBinomial(1000, 0.3));
+}
+
+
+// Checks the checkpoint round trip of Engine, and that a checkpoint of the Other engine type is refused
+template <class Engine, class Other>
+static void CheckEngineState()
+{
+  SCOPED_TRACE(typeid(Engine).name());
+  
+  Engine rng(2013);
+  for (int i = 0; i < 77; i++) rng.GetUInt();
+  rng.GetRandNormal();
+  
+  Apto::Array<unsigned char> state(rng.StateSize());
+  EXPECT_FALSE(rng.SaveState(&state[0], state.GetSize() - 1));
+  EXPECT_TRUE(rng.SaveState(&state[0], state.GetSize()));
+  
+  // A generator restored from the checkpoint continues identically, including seeds and the normal deviate cache
+  Engine restored(1);
+  EXPECT_TRUE(restored.RestoreState(&state[0], state.GetSize()));
+  EXPECT_EQ(rng.Seed(), restored.Seed());
+  EXPECT_EQ(rng.OriginalSeed(), restored.OriginalSeed());
+  for (int i = 0; i < 100; i++) EXPECT_EQ(rng.GetUInt(), restored.GetUInt());
+  EXPECT_EQ(rng.GetRandNormal(), restored.GetRandNormal());
+  
+  // Padded out to the size of the Engine checkpoint, so only the engine tag can reject it
+  Other other(2013);
+  Apto::Array<unsigned char> other_state(other.StateSize());
+  other.SaveState(&other_state[0], other_state.GetSize());
+  Apto::Array<unsigned char> padded(other_state.GetSize() + state.GetSize());
+  padded.SetAll(0);
+  for (int i = 0; i < other_state.GetSize(); i++) padded[i] = other_state[i];
+  EXPECT_FALSE(restored.RestoreState(&padded[0], padded.GetSize()));
+}
+
+
+TEST(CoreRandom, EngineState) {
+  CheckEngineState<Apto::RNG::AvidaRNG, Apto::RNG::SplitMix64>();
+  CheckEngineState<Apto::RNG::AvidaRNGLanes, Apto::RNG::AvidaRNG>();
+  CheckEngineState<Apto::RNG::PCG64, Apto::RNG::Xoshiro256StarStar>();
+  CheckEngineState<Apto::RNG::Philox, Apto::RNG::PCG64>();
+  CheckEngineState<Apto::RNG::SplitMix64, Apto::RNG::PCG64>();
+  CheckEngineState<Apto::RNG::Xoshiro256StarStar, Apto::RNG::Philox>();
+}
+
+TEST(CoreRandom, NormalMethod) {
+  // Restricted range generators keep the original method so that existing results are reproduced
+  Apto::RNG::AvidaRNG avida(1);
+  EXPECT_EQ(Apto::Random::NORMAL_REJECTION, avida.GetNormalMethod());
+  Apto::RNG::Xoshiro256StarStar xoshiro(1);
+  EXPECT_EQ(Apto::Random::NORMAL_ZIGGURAT, xoshiro.GetNormalMethod());
+  
+  Apto::RNG::AvidaRNG ziggurat(1);
+  ziggurat.SetNormalMethod(Apto::Random::NORMAL_ZIGGURAT);
+  EXPECT_NE(avida.GetRandNormal(), ziggurat.GetRandNormal());
+}
+
+
+TEST(CoreRandom, GetRandNormal) {
+  // 42 degrees of freedom, p = 0.001 critical value of 76.1
+  Apto::RNG::Xoshiro256StarStar rng(3);
+  EXPECT_GT(76.1, BinnedChiSquare(NormalSampler(rng), NormalCDF, -4.0, 4.0, 40, 200000));
+  
+  rng.SetNormalMethod(Apto::Random::NORMAL_REJECTION);
+  EXPECT_GT(76.1, BinnedChiSquare(NormalSampler(rng), NormalCDF, -4.0, 4.0, 40, 200000));
+  
+  // The ziggurat should also handle restricted range generators
+  Apto::RNG::AvidaRNG avida(3);
+  avida.SetNormalMethod(Apto::Random::NORMAL_ZIGGURAT);
+  EXPECT_GT(76.1, BinnedChiSquare(NormalSampler(avida), NormalCDF, -4.0, 4.0, 40, 200000));
+}
+
+
+TEST(CoreRandom, GetRandExponential) {
+  // One empty bin below zero leaves 41 degrees of freedom, p = 0.001 critical value of 74.7
+  Apto::RNG::Xoshiro256StarStar rng(4);
+  EXPECT_GT(74.7, BinnedChiSquare(ExponentialSampler(rng), ExponentialCDF, 0.0, 10.0, 40, 200000));
+  
+  double sum = 0.0;
+  for (int i = 0; i < 10000; i++) sum += rng.GetRandExponential(2.5);
+  EXPECT_NEAR(2.5, sum / 10000, 0.1);
+}
+
+
+// Chi-square statistic of discrete samples against a log probability mass function over [low, high], with the
+// remaining mass on either side pooled into tail bins
+template <class Sampler, class LogPMF>
+static double DiscreteChiSquare(Sampler sample, LogPMF log_pmf, int low, int high, int draws)
+{
+  const int bins = high - low + 3;
+  Apto::Array<int> counts(bins);
+  counts.SetAll(0);
+  for (int i = 0; i < draws; i++) {
+    int value = static_cast<int>(sample());
+    counts[(value < low) ? 0 : ((value > high) ? bins - 1 : value - low + 1)]++;
+  }
+  
+  double central_mass = 0.0;
+  double chi_square = 0.0;
+  for (int k = low; k <= high; k++) {
+    double expected = draws * exp(log_pmf(k));
+    central_mass += expected / draws;
+    double diff = counts[k - low + 1] - expected;
+    chi_square += diff * diff / expected;
+  }
+  
+  // Tail counts are compared together, the lower and upper split is not tracked by the pooled expectation
+  double tail_expected = draws * (1.0 - central_mass);
+  double tail_count = counts[0] + counts[bins - 1];
+  if (tail_expected > 1.0) chi_square += (tail_count - tail_expected) * (tail_count - tail_expected) / tail_expected;
+  return chi_square;
+}
+
+struct BinomialLogPMF
+{
+  int n;
+  double p;
+  BinomialLogPMF(int in_n, double in_p) : n(in_n), p(in_p) { ; }
+  double operator()(int k) { return lgamma(n + 1.0) - lgamma(k + 1.0) - lgamma(n - k + 1.0) + k * log(p) + (n - k) * log(1.0 - p); }
+};
+
+struct PoissonLogPMF
+{
+  double mean;
+  PoissonLogPMF(double in_mean) : mean(in_mean) { ; }
+  double operator()(int k) { return k * log(mean) - mean - lgamma(k + 1.0); }
+};
+
+struct BinomialSampler
+{
+  Apto::Random& rng;
+  double n, p;
+  BinomialSampler(Apto::Random& in_rng, double in_n, double in_p) : rng(in_rng), n(in_n), p(in_p) { ; }
+  unsigned int operator()() { return rng.GetRandBinomial(n, p); }
+};
+
+struct PoissonSampler
+{
+  Apto::Random& rng;
+  double mean;
+  PoissonSampler(Apto::Random& in_rng, double in_mean) : rng(in_rng), mean(in_mean) { ; }
+  unsigned int operator()() { return rng.GetRandPoisson(mean); }
+};
+
+
+TEST(CoreRandom, GetRandBinomial) {
+  Apto::RNG::Xoshiro256StarStar rng(5);
+  EXPECT_EQ(Apto::Random::DISCRETE_EXACT, rng.GetDiscreteMethod());
+  
+  // Critical values are taken at p = 0.001 for the number of central bins plus the pooled tail, less one
+  EXPECT_GT(32.9, DiscreteChiSquare(BinomialSampler(rng, 50, 0.1), BinomialLogPMF(50, 0.1), 0, 12, 100000));      // inversion
+  EXPECT_GT(99.6, DiscreteChiSquare(BinomialSampler(rng, 1000, 0.3), BinomialLogPMF(1000, 0.3), 260, 320, 100000)); // BTPE
+  EXPECT_GT(99.6, DiscreteChiSquare(BinomialSampler(rng, 1000, 0.7), BinomialLogPMF(1000, 0.7), 680, 740, 100000)); // complement
+  
+  EXPECT_EQ(0u, rng.GetRandBinomial(0, 0.5));
+  EXPECT_EQ(0u, rng.GetRandBinomial(100, 0.0));
+  EXPECT_EQ(100u, rng.GetRandBinomial(100, 1.0));
+  
+  // Large trial counts stay exact and cheap
+  double sum = 0.0;
+  for (int i = 0; i < 10000; i++) sum += rng.GetRandBinomial(100000000, 0.001);
+  EXPECT_NEAR(100000.0, sum / 10000, 10.0);
+  
+  Apto::RNG::AvidaRNG avida(5);
+  EXPECT_EQ(Apto::Random::DISCRETE_APPROXIMATE, avida.GetDiscreteMethod());
+  avida.SetDiscreteMethod(Apto::Random::DISCRETE_EXACT);
+  EXPECT_GT(99.6, DiscreteChiSquare(BinomialSampler(avida, 1000, 0.3), BinomialLogPMF(1000, 0.3), 260, 320, 100000));
+}
+
+
+TEST(CoreRandom, GetRandPoisson) {
+  Apto::RNG::Xoshiro256StarStar rng(6);
+  EXPECT_GT(32.9, DiscreteChiSquare(PoissonSampler(rng, 3.0), PoissonLogPMF(3.0), 0, 12, 100000));      // inversion
+  EXPECT_GT(88.0, DiscreteChiSquare(PoissonSampler(rng, 50.0), PoissonLogPMF(50.0), 25, 75, 100000));   // PTRS
+  EXPECT_GT(88.0, DiscreteChiSquare(PoissonSampler(rng, 10.0), PoissonLogPMF(10.0), 0, 50, 100000));    // PTRS at its limit
+  EXPECT_EQ(0u, rng.GetRandPoisson(0.0));
+  
+  // Means far beyond the range of exp(-mean) are supported
+  double sum = 0.0;
+  for (int i = 0; i < 10000; i++) sum += rng.GetRandPoisson(1000000.0);
+  EXPECT_NEAR(1000000.0, sum / 10000, 50.0);
+}
+
+
+TEST(CoreRandom, Choose) {
+  Apto::RNG::Xoshiro256StarStar rng(211);
+  
+  // Exercise the dense, scanned and set based paths, checking for distinct in range choices
+  const int sizes[][2] = { {10, 10}, {10, 7}, {1000, 20}, {100000, 500} };
+  for (int s = 0; s < 4; s++) {
+    const int num_in = sizes[s][0];
+    Apto::Array<int> chosen(sizes[s][1]);
+    Apto::Array<bool> seen(num_in);
+    for (int rep = 0; rep < 20; rep++) {
+      rng.Choose(num_in, chosen);
+      seen.SetAll(false);
+      for (int i = 0; i < chosen.GetSize(); i++) {
+        ASSERT_GE(chosen[i], 0);
+        ASSERT_LT(chosen[i], num_in);
+        EXPECT_FALSE(seen[chosen[i]]);
+        seen[chosen[i]] = true;
+      }
+    }
+  }
+  
+  // The last output position should be uniform over the inputs on the dense, scanned and set based paths (binned
+  // mod 8, 7 degrees of freedom, p = 0.001)
+  const int cases[][2] = { {8, 3}, {200, 5}, {400, 40} };
+  for (int c = 0; c < 3; c++) {
+    Apto::Array<int> chosen(cases[c][1]);
+    int counts[8] = { 0 };
+    const int draws = 40000;
+    for (int i = 0; i < draws; i++) {
+      rng.Choose(cases[c][0], chosen);
+      counts[chosen[chosen.GetSize() - 1] % 8]++;
+    }
+    double chi2 = 0.0;
+    const double expected = draws / 8.0;
+    for (int i = 0; i < 8; i++) chi2 += (counts[i] - expected) * (counts[i] - expected) / expected;
+    EXPECT_LT(chi2, 24.3);
+  }
+}
+
+
+TEST(CoreRandom, ChooseStream) {
+  Apto::RNG::Xoshiro256StarStar rng(223);
+  
+  Apto::Array<int> stream(20);
+  for (int i = 0; i < stream.GetSize(); i++) stream[i] = 100 + i;
+  
+  // Short streams fill only the leading entries
+  Apto::Array<int> short_stream(3);
+  for (int i = 0; i < short_stream.GetSize(); i++) short_stream[i] = i;
+  Apto::Array<int> chosen(5);
+  chosen.SetAll(-1);
+  Apto::Array<int>::Iterator short_it = short_stream.Begin();
+  EXPECT_EQ(3, rng.ChooseStream(short_it, chosen));
+  for (int i = 0; i < 3; i++) EXPECT_EQ(i, chosen[i]);
+  EXPECT_EQ(-1, chosen[3]);
+  
+  // Every item should be retained with probability k / n
+  Apto::Array<int> counts(stream.GetSize());
+  counts.SetAll(0);
+  const int draws = 40000;
+  for (int d = 0; d < draws; d++) {
+    Apto::Array<int>::Iterator it = stream.Begin();
+    EXPECT_EQ(stream.GetSize(), rng.ChooseStream(it, chosen));
+    for (int i = 0; i < chosen.GetSize(); i++) {
+      ASSERT_GE(chosen[i], 100);
+      ASSERT_LT(chosen[i], 120);
+      counts[chosen[i] - 100]++;
+      for (int j = 0; j < i; j++) EXPECT_NE(chosen[i], chosen[j]);
+    }
+  }
+  double chi2 = 0.0;
+  const double expected = static_cast<double>(draws) * chosen.GetSize() / stream.GetSize();
+  for (int i = 0; i < counts.GetSize(); i++) chi2 += (counts[i] - expected) * (counts[i] - expected) / expected;
+  EXPECT_LT(chi2, 43.8);
+}
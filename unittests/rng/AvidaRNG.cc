@@ -0,0 +1,116 @@
+/*
+ *  unittests/rng/AvidaRNG.cc
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#include "apto/rng/AvidaRNG.h"
+
+#include "apto/core/Array.h"
+#include "apto/core/SmartPtr.h"
+
+#include "gtest/gtest.h"
+
+
+TEST(RNGAvidaRNG, Streams) {
+  Apto::RNG::AvidaRNG rng(42);
+  Apto::SmartPtr<Apto::Random> stream_a(rng.CreateStream(0));
+  Apto::SmartPtr<Apto::Random> stream_b(rng.CreateStream(0));
+  Apto::SmartPtr<Apto::Random> stream_c(rng.CreateStream(1));
+  
+  // Streams are reproducible from the parent seed and stream ID, and distinct across IDs
+  EXPECT_EQ(stream_a->Seed(), stream_b->Seed());
+  EXPECT_NE(stream_a->Seed(), stream_c->Seed());
+  for (int i = 0; i < 100; i++) EXPECT_EQ(stream_a->GetUInt(1000000), stream_b->GetUInt(1000000));
+}
+
+
+TEST(RNGAvidaRNG, FillDouble) {
+  Apto::RNG::AvidaRNG bulk(1);
+  Apto::RNG::AvidaRNG scalar(1);
+  Apto::Random& bulk_base = bulk;
+  
+  Apto::Array<double> values(1000);
+  bulk_base.FillDouble(&values[0], values.GetSize());
+  for (int i = 0; i < values.GetSize(); i++) EXPECT_EQ(scalar.GetDouble(), values[i]);
+  
+  // Bulk and scalar draws may be interleaved
+  bulk.FillDouble(&values[0], 1);
+  EXPECT_EQ(scalar.GetDouble(), values[0]);
+  EXPECT_EQ(scalar.GetDouble(), bulk.GetDouble());
+}
+
+
+TEST(RNGAvidaRNG, FillUInt) {
+  Apto::RNG::AvidaRNG bulk(2);
+  Apto::RNG::AvidaRNG scalar(2);
+  
+  Apto::Array<unsigned int> values(1000);
+  bulk.FillUInt(&values[0], values.GetSize(), 37);
+  for (int i = 0; i < values.GetSize(); i++) {
+    EXPECT_GT(37u, values[i]);
+    EXPECT_EQ(scalar.GetUInt(37), values[i]);
+  }
+}
+
+
+TEST(RNGAvidaRNG, FillBernoulli) {
+  Apto::RNG::AvidaRNG bulk(3);
+  Apto::RNG::AvidaRNG scalar(3);
+  
+  Apto::Array<bool> values(1000);
+  bulk.FillBernoulli(&values[0], values.GetSize(), 0.25);
+  int successes = 0;
+  for (int i = 0; i < values.GetSize(); i++) {
+    EXPECT_EQ(scalar.P(0.25), values[i]);
+    if (values[i]) successes++;
+  }
+  EXPECT_NEAR(250, successes, 50);
+}
+
+
+TEST(RNGAvidaRNG, GetUInt) {
+  Apto::RNG::AvidaRNG rng(4);
+  Apto::RNG::AvidaRNG twin(4);
+  
+  // Range draws on the Avida generator reproduce the original floating point mapping
+  for (int i = 0; i < 100; i++) EXPECT_EQ(static_cast<unsigned int>(twin.GetDouble() * 1000), rng.GetUInt(1000));
+  for (int i = 0; i < 100; i++) EXPECT_EQ(static_cast<int>(twin.GetDouble() * 1000), rng.GetInt(1000));
+  
+  // Full 32-bit draws should reach the upper half of the range about half of the time
+  int high = 0;
+  for (int i = 0; i < 10000; i++) if (rng.GetUInt() >= 0x80000000u) high++;
+  EXPECT_NEAR(5000, high, 300);
+  
+  for (int i = 0; i < 1000; i++) EXPECT_GT(3u, rng.GetBoundedUInt(3));
+}
+
+
+TEST(RNGAvidaRNG, State) {
+  Apto::RNG::AvidaRNG rng(2013);
+  EXPECT_EQ(4 + 4 + 4 + 4 + 4 + 8 + 4 * (2 + 56), rng.StateSize());
+}
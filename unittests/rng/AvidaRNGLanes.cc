@@ -0,0 +1,91 @@
+/*
+ *  unittests/rng/AvidaRNGLanes.cc
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#include "apto/rng/AvidaRNGLanes.h"
+
+#include "apto/core/Array.h"
+#include "apto/rng/AvidaRNG.h"
+
+#include "gtest/gtest.h"
+
+
+static const int LANES = Apto::RNG::AvidaRNGLanes::LANES;
+
+
+TEST(RNGAvidaRNGLanes, Lanes) {
+  Apto::RNG::AvidaRNGLanes lanes(5);
+  
+  // Each reference consumes its first value during seeding, just as the first row of lanes has been buffered
+  Apto::Array<Apto::RNG::AvidaRNG*> reference(LANES);
+  for (int l = 0; l < LANES; l++) reference[l] = new Apto::RNG::AvidaRNG(lanes.LaneSeed(l));
+  
+  Apto::Array<unsigned int> rows(100 * LANES);
+  lanes.FillLanes(&rows[0], 100);
+  for (int r = 0; r < 100; r++) {
+    for (int l = 0; l < LANES; l++) EXPECT_EQ(reference[l]->GetUInt(1000000000), rows[r * LANES + l]);
+  }
+  
+  for (int l = 0; l < LANES; l++) delete reference[l];
+}
+
+
+TEST(RNGAvidaRNGLanes, Random) {
+  Apto::RNG::AvidaRNGLanes lanes(9);
+  Apto::Array<Apto::RNG::AvidaRNG*> reference(LANES);
+  for (int l = 0; l < LANES; l++) reference[l] = new Apto::RNG::AvidaRNG(lanes.LaneSeed(l));
+  
+  // The Random interface walks the lanes row by row, starting with the remainder of the first row
+  for (int l = 1; l < LANES; l++) lanes.GetDouble();
+  for (int r = 0; r < 100; r++) {
+    for (int l = 0; l < LANES; l++) EXPECT_EQ(reference[l]->GetDouble(), lanes.GetDouble());
+  }
+  
+  for (int l = 0; l < LANES; l++) delete reference[l];
+}
+
+
+TEST(RNGAvidaRNGLanes, Fill) {
+  Apto::RNG::AvidaRNGLanes bulk(3);
+  Apto::RNG::AvidaRNGLanes scalar(3);
+  
+  Apto::Array<double> values(1001);
+  bulk.FillDouble(&values[0], values.GetSize());
+  for (int i = 0; i < values.GetSize(); i++) EXPECT_EQ(scalar.GetDouble(), values[i]);
+  
+  Apto::Array<unsigned int> uints(1001);
+  bulk.FillUInt(&uints[0], uints.GetSize(), 6);
+  for (int i = 0; i < uints.GetSize(); i++) EXPECT_EQ(scalar.GetUInt(6), uints[i]);
+}
+
+
+TEST(RNGAvidaRNGLanes, State) {
+  Apto::RNG::AvidaRNGLanes rng(2013);
+  EXPECT_EQ(4 + 4 + 4 + 4 + 4 + 8 + 4 * (2 + 56 * LANES + LANES + 1), rng.StateSize());
+}
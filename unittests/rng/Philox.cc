@@ -0,0 +1,130 @@
+/*
+ *  unittests/rng/Philox.cc
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#include "apto/rng/Philox.h"
+
+#include "apto/core/Array.h"
+#include "apto/core/SmartPtr.h"
+
+#include "gtest/gtest.h"
+
+
+TEST(RNGPhilox, KnownAnswer) {
+  // Philox4x32-10 known answer vectors from the Random123 distribution
+  uint32_t out[4];
+  Apto::RNG::Philox::Block(0, 0, 0, out);
+  EXPECT_EQ(0x6627E8D5u, out[0]);
+  EXPECT_EQ(0xE169C58Du, out[1]);
+  EXPECT_EQ(0xBC57AC4Cu, out[2]);
+  EXPECT_EQ(0x9B00DBD8u, out[3]);
+  
+  Apto::RNG::Philox::Block(0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL, out);
+  EXPECT_EQ(0x408F276Du, out[0]);
+  EXPECT_EQ(0x41C83B0Eu, out[1]);
+  EXPECT_EQ(0xA20BC7C6u, out[2]);
+  EXPECT_EQ(0x6D5451FDu, out[3]);
+  
+  Apto::RNG::Philox::Block(0x299F31D0A4093822ULL, 0x0370734413198A2EULL, 0x85A308D3243F6A88ULL, out);
+  EXPECT_EQ(0xD16CFE09u, out[0]);
+  EXPECT_EQ(0x94FDCCEBu, out[1]);
+  EXPECT_EQ(0x5001E420u, out[2]);
+  EXPECT_EQ(0x24126EA1u, out[3]);
+}
+
+
+TEST(RNGPhilox, RandomAccess) {
+  // The sequential interface produces draws 0, 1, 2, ... of the stream
+  Apto::RNG::Philox rng(42, 5);
+  EXPECT_EQ(0u, rng.Position());
+  EXPECT_EQ(Apto::RNG::Philox::SeedKey(42), rng.Key());
+  for (uint64_t i = 0; i < 100; i++) {
+    EXPECT_EQ(Apto::RNG::Philox::Draw(rng.Key(), 5, i), rng.GetUInt());
+  }
+  EXPECT_EQ(100u, rng.Position());
+  EXPECT_EQ(Apto::RNG::Philox::DrawDouble(rng.Key(), 5, 100), rng.GetDouble());
+  
+  // Seeking anywhere, including back and into the middle of a block
+  const uint64_t positions[] = { 7, 3, 1000000000000ULL, 2 };
+  for (int p = 0; p < 4; p++) {
+    rng.Seek(positions[p]);
+    EXPECT_EQ(rng.At(positions[p]), rng.GetUInt());
+    EXPECT_EQ(rng.At(positions[p] + 1), rng.GetUInt());
+  }
+  
+  // Filling ranges in any order reproduces the sequence
+  Apto::Array<unsigned int> sequential(37);
+  Apto::RNG::Philox::Fill(rng.Key(), 9, 3, &sequential[0], sequential.GetSize());
+  Apto::Array<unsigned int> pieces(37);
+  Apto::RNG::Philox::Fill(rng.Key(), 9, 23, &pieces[20], 17);
+  Apto::RNG::Philox::Fill(rng.Key(), 9, 3, &pieces[0], 1);
+  Apto::RNG::Philox::Fill(rng.Key(), 9, 4, &pieces[1], 19);
+  for (int i = 0; i < sequential.GetSize(); i++) {
+    EXPECT_EQ(Apto::RNG::Philox::Draw(rng.Key(), 9, 3 + i), sequential[i]);
+    EXPECT_EQ(sequential[i], pieces[i]);
+  }
+}
+
+
+TEST(RNGPhilox, Streams) {
+  Apto::RNG::Philox rng(42);
+  Apto::SmartPtr<Apto::Random> stream_a(rng.CreateStream(3));
+  Apto::SmartPtr<Apto::Random> stream_b(rng.CreateStream(4));
+  Apto::RNG::Philox direct(42, 3);
+  for (int i = 0; i < 10; i++) {
+    unsigned int value = stream_a->GetUInt();
+    EXPECT_EQ(direct.GetUInt(), value);
+    EXPECT_NE(value, stream_b->GetUInt());
+  }
+  
+  // Reseeding restarts the stream at draw 0
+  direct.ResetSeed(42);
+  EXPECT_EQ(0u, direct.Position());
+  EXPECT_EQ(rng.At(0), Apto::RNG::Philox(42).GetUInt());
+}
+
+
+TEST(RNGPhilox, Fill) {
+  Apto::RNG::Philox bulk(11);
+  Apto::RNG::Philox scalar(11);
+  
+  Apto::Array<double> values(1001);
+  bulk.FillDouble(&values[0], values.GetSize());
+  for (int i = 0; i < values.GetSize(); i++) EXPECT_EQ(scalar.GetDouble(), values[i]);
+  
+  Apto::Array<unsigned int> bounded(999);
+  bulk.FillUInt(&bounded[0], bounded.GetSize(), 37);
+  for (int i = 0; i < bounded.GetSize(); i++) EXPECT_EQ(scalar.GetUInt(37), bounded[i]);
+}
+
+
+TEST(RNGPhilox, State) {
+  Apto::RNG::Philox rng(2013);
+  EXPECT_EQ(4 + 4 + 4 + 4 + 4 + 8 + 24, rng.StateSize());
+}
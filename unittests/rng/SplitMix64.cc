@@ -0,0 +1,100 @@
+/*
+ *  unittests/rng/SplitMix64.cc
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#include "apto/rng/SplitMix64.h"
+
+#include "apto/core/Array.h"
+#include "apto/core/SmartPtr.h"
+
+#include "gtest/gtest.h"
+
+
+TEST(RNGSplitMix64, Sequence) {
+  // Reference output of the published SplitMix64 implementation for seed 1234567
+  const uint64_t expected[] = {
+    0x599ED017FB08FC85ULL, 0x2C73F08458540FA5ULL, 0x883EBCE5A3F27C77ULL, 0x3FBEF740E9177B3FULL, 0xE3B8346708CB5ECDULL
+  };
+  uint64_t state = 1234567;
+  for (int i = 0; i < 5; i++) EXPECT_EQ(expected[i], Apto::RNG::SplitMix64::Next(state));
+  
+  // Seeding consumes the first draw
+  Apto::RNG::SplitMix64 rng(1234567);
+  for (int i = 1; i < 5; i++) EXPECT_EQ(expected[i], rng.GetUInt64());
+}
+
+
+TEST(RNGSplitMix64, Jump) {
+  Apto::RNG::SplitMix64 jumped(7);
+  Apto::RNG::SplitMix64 stepped(7);
+  
+  jumped.Advance(1000);
+  for (int i = 0; i < 1000; i++) stepped.GetUInt64();
+  EXPECT_EQ(stepped.GetUInt64(), jumped.GetUInt64());
+  
+  Apto::SmartPtr<Apto::Random> stream_a(stepped.CreateStream(0));
+  Apto::SmartPtr<Apto::Random> stream_b(stepped.CreateStream(1));
+  EXPECT_NE(stream_a->GetUInt(1000000000), stream_b->GetUInt(1000000000));
+  
+  // High stream IDs must neither wrap onto the parent nor onto lower IDs
+  Apto::RNG::SplitMix64 parent(7);
+  Apto::SmartPtr<Apto::Random> stream_high(parent.CreateStream(65535));
+  Apto::SmartPtr<Apto::Random> stream_wrap(parent.CreateStream(65536));
+  Apto::SmartPtr<Apto::Random> stream_zero(parent.CreateStream(0));
+  Apto::SmartPtr<Apto::Random> stream_zero_again(parent.CreateStream(0));
+  unsigned int parent_value = parent.GetUInt();
+  unsigned int zero_value = stream_zero->GetUInt();
+  EXPECT_NE(parent_value, stream_high->GetUInt());
+  EXPECT_NE(zero_value, stream_wrap->GetUInt());
+  EXPECT_EQ(zero_value, stream_zero_again->GetUInt());
+}
+
+
+TEST(RNGSplitMix64, Fill) {
+  Apto::RNG::SplitMix64 bulk(11);
+  Apto::RNG::SplitMix64 scalar(11);
+  
+  Apto::Array<double> values(1000);
+  bulk.FillDouble(&values[0], values.GetSize());
+  for (int i = 0; i < values.GetSize(); i++) {
+    EXPECT_LE(0.0, values[i]);
+    EXPECT_GT(1.0, values[i]);
+    EXPECT_EQ(scalar.GetDouble(), values[i]);
+  }
+  
+  Apto::Array<bool> coins(1000);
+  bulk.FillBernoulli(&coins[0], coins.GetSize(), 0.5);
+  for (int i = 0; i < coins.GetSize(); i++) EXPECT_EQ(scalar.P(0.5), coins[i]);
+}
+
+
+TEST(RNGSplitMix64, State) {
+  Apto::RNG::SplitMix64 rng(2013);
+  EXPECT_EQ(4 + 4 + 4 + 4 + 4 + 8 + 16, rng.StateSize());
+}
@@ -0,0 +1,242 @@
+/*
+ *  unittests/scheduler/Concurrent.cc
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#include "apto/scheduler/Concurrent.h"
+#include "apto/scheduler/Probabilistic.h"
+#include "apto/scheduler/RoundRobin.h"
+
+#include "apto/core/Thread.h"
+#include "apto/rng/AvidaRNG.h"
+
+#include "gtest/gtest.h"
+
+
+static Apto::PriorityScheduler* CreateRoundRobin(int entry_count, int)
+{
+  return new Apto::Scheduler::RoundRobin(entry_count);
+}
+
+static Apto::PriorityScheduler* CreateProbabilistic(int entry_count, int shard_id)
+{
+  return new Apto::Scheduler::Probabilistic(entry_count, Apto::SmartPtr<Apto::Random>(new Apto::RNG::AvidaRNG(shard_id + 1)));
+}
+
+static Apto::PriorityScheduler* CreateStreamProbabilistic(int entry_count, Apto::SmartPtr<Apto::Random> rng)
+{
+  return new Apto::Scheduler::Probabilistic(entry_count, rng);
+}
+
+
+TEST(SchedulerConcurrent, Construction) {
+  Apto::Scheduler::Concurrent sched(10, 3, CreateRoundRobin);
+  EXPECT_EQ(3, sched.NumWorkers());
+  EXPECT_EQ(10, sched.EntryLimit());
+  EXPECT_EQ(10, sched.GetWorker(0).EntryLimit());
+  
+  // No active entries, nothing to schedule
+  for (int i = 0; i < sched.NumWorkers(); i++) EXPECT_EQ(-1, sched.GetWorker(i).Next());
+}
+
+
+TEST(SchedulerConcurrent, Next) {
+  const int entry_count = 20;
+  Apto::Scheduler::Concurrent sched(entry_count, 4, CreateRoundRobin);
+  for (int i = 0; i < entry_count; i++) sched.AdjustPriority(i, 1.0);
+  
+  // Every entry should be reachable through exactly one worker
+  Apto::Array<int> owner(entry_count);
+  owner.SetAll(-1);
+  for (int w = 0; w < sched.NumWorkers(); w++) {
+    for (int i = 0; i < entry_count; i++) {
+      int entry_id = sched.GetWorker(w).Next();
+      ASSERT_GE(entry_id, 0);
+      ASSERT_LT(entry_id, entry_count);
+      if (owner[entry_id] == -1) owner[entry_id] = w;
+      EXPECT_EQ(w, owner[entry_id]);
+    }
+  }
+  for (int i = 0; i < entry_count; i++) EXPECT_NE(-1, owner[i]);
+  
+  // Deactivated entries should no longer be scheduled
+  for (int i = 0; i < entry_count; i++) if (owner[i] == 0) sched.AdjustPriority(i, 0.0);
+  EXPECT_EQ(-1, sched.GetWorker(0).Next());
+  EXPECT_NE(-1, sched.GetWorker(1).Next());
+}
+
+
+TEST(SchedulerConcurrent, Rebalance) {
+  const int entry_count = 100;
+  Apto::Scheduler::Concurrent sched(entry_count, 2, CreateProbabilistic);
+  
+  // Entries are interleaved across shards, so even entries all land in the first shard
+  for (int i = 0; i < entry_count; i++) sched.AdjustPriority(i, (i % 2) ? 1.0 : 9.0);
+  sched.Synchronize();
+  EXPECT_DOUBLE_EQ(450.0, sched.ShardWeight(0));
+  EXPECT_DOUBLE_EQ(50.0, sched.ShardWeight(1));
+  
+  EXPECT_TRUE(sched.Rebalance());
+  EXPECT_DOUBLE_EQ(250.0, sched.ShardWeight(0));
+  EXPECT_DOUBLE_EQ(250.0, sched.ShardWeight(1));
+  EXPECT_FALSE(sched.Rebalance());
+  
+  // All entries must still be scheduled after relocation
+  Apto::Array<int> counts(entry_count);
+  counts.SetAll(0);
+  for (int w = 0; w < sched.NumWorkers(); w++) {
+    for (int i = 0; i < 20000; i++) counts[sched.GetWorker(w).Next()]++;
+  }
+  for (int i = 0; i < entry_count; i++) EXPECT_LT(0, counts[i]);
+}
+
+
+TEST(SchedulerConcurrent, Threaded) {
+  class WorkerThread : public Apto::Thread
+  {
+  private:
+    Apto::PriorityScheduler& m_worker;
+    int m_seed;
+    
+  public:
+    bool valid;
+    
+    WorkerThread(Apto::PriorityScheduler& worker, int seed) : m_worker(worker), m_seed(seed), valid(true) { ; }
+    
+  protected:
+    void Run()
+    {
+      Apto::RNG::AvidaRNG rng(m_seed);
+      for (int i = 0; i < 10000; i++) {
+        int entry_id = m_worker.Next();
+        if (entry_id < 0 || entry_id >= m_worker.EntryLimit()) valid = false;
+        m_worker.AdjustPriority(rng.GetInt(m_worker.EntryLimit()), 1.0 + rng.GetInt(4));
+      }
+    }
+  };
+  
+  const int entry_count = 1000;
+  const int num_workers = 4;
+  Apto::Scheduler::Concurrent sched(entry_count, num_workers, CreateRoundRobin);
+  for (int i = 0; i < entry_count; i++) sched.AdjustPriority(i, 1.0);
+  
+  Apto::Array<WorkerThread*> threads(num_workers);
+  for (int i = 0; i < num_workers; i++) {
+    threads[i] = new WorkerThread(sched.GetWorker(i), i + 1);
+    threads[i]->Start();
+  }
+  for (int i = 0; i < num_workers; i++) {
+    threads[i]->Join();
+    EXPECT_TRUE(threads[i]->valid);
+    delete threads[i];
+  }
+  
+  sched.Synchronize();
+  double total_weight = 0.0;
+  for (int i = 0; i < num_workers; i++) total_weight += sched.ShardWeight(i);
+  EXPECT_LE(1000.0, total_weight);
+  EXPECT_GE(4000.0, total_weight);
+}
+
+
+class DeterministicWorkerThread : public Apto::Thread
+{
+private:
+  Apto::PriorityScheduler& m_worker;
+  
+public:
+  Apto::Array<int, Apto::Smart> schedule;
+  
+  DeterministicWorkerThread(Apto::PriorityScheduler& worker) : m_worker(worker) { ; }
+  
+  void Run()
+  {
+    for (int i = 0; i < 500; i++) {
+      int entry_id = m_worker.Next();
+      schedule.Push(entry_id);
+      if (entry_id >= 0) m_worker.AdjustPriority((entry_id * 7) % m_worker.EntryLimit(), 1.0 + (entry_id % 5));
+    }
+  }
+};
+
+static void RunDeterministicSchedule(bool threaded, Apto::Array<Apto::Array<int, Apto::Smart> >& schedules)
+{
+  const int entry_count = 300;
+  const int num_workers = 3;
+  Apto::Scheduler::Concurrent sched(entry_count, num_workers, Apto::SmartPtr<Apto::Random>(new Apto::RNG::AvidaRNG(42)),
+                                    CreateStreamProbabilistic);
+  for (int i = 0; i < entry_count; i++) sched.AdjustPriority(i, 1.0);
+  sched.Synchronize();
+  
+  Apto::Array<DeterministicWorkerThread*> threads(num_workers);
+  for (int i = 0; i < num_workers; i++) threads[i] = new DeterministicWorkerThread(sched.GetWorker(i));
+  
+  for (int cycle = 0; cycle < 5; cycle++) {
+    if (threaded) {
+      for (int i = 0; i < num_workers; i++) threads[i]->Start();
+      for (int i = 0; i < num_workers; i++) threads[i]->Join();
+    } else {
+      for (int i = num_workers - 1; i >= 0; i--) threads[i]->Run();
+    }
+    sched.Synchronize();
+    sched.Rebalance();
+  }
+  
+  schedules.Resize(num_workers);
+  for (int i = 0; i < num_workers; i++) {
+    schedules[i] = threads[i]->schedule;
+    delete threads[i];
+  }
+}
+
+TEST(SchedulerConcurrent, Deterministic) {
+  Apto::Scheduler::Concurrent sched(10, 2, Apto::SmartPtr<Apto::Random>(new Apto::RNG::AvidaRNG(1)),
+                                    CreateStreamProbabilistic);
+  EXPECT_TRUE(sched.IsDeterministic());
+  
+  // Adjustments are deferred until synchronized
+  sched.GetWorker(0).AdjustPriority(0, 1.0);
+  EXPECT_EQ(-1, sched.GetWorker(0).Next());
+  sched.Synchronize();
+  EXPECT_EQ(0, sched.GetWorker(0).Next());
+  
+  // Threaded execution must reproduce the sequential reference schedule exactly
+  Apto::Array<Apto::Array<int, Apto::Smart> > reference;
+  Apto::Array<Apto::Array<int, Apto::Smart> > threaded;
+  RunDeterministicSchedule(false, reference);
+  RunDeterministicSchedule(true, threaded);
+  
+  ASSERT_EQ(reference.GetSize(), threaded.GetSize());
+  for (int i = 0; i < reference.GetSize(); i++) {
+    EXPECT_EQ(2500, reference[i].GetSize());
+    EXPECT_TRUE(reference[i] == threaded[i]);
+  }
+  
+  // Each shard should have drawn from a distinct random number stream
+  EXPECT_FALSE(reference[0] == reference[1]);
+}
@@ -0,0 +1,86 @@
+/*
+ *  unittests/scheduler/ProbabilisticIntegrated.cc
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#include "apto/scheduler/ProbabilisticIntegrated.h"
+
+#include "apto/core/Array.h"
+#include "apto/core/SmartPtr.h"
+#include "apto/rng/AvidaRNG.h"
+
+#include "gtest/gtest.h"
+
+
+TEST(SchedulerProbabilisticIntegrated, Next) {
+  const int entry_count = 4;
+  const int draws = 40000;
+  Apto::Scheduler::ProbabilisticIntegrated sched(entry_count, Apto::SmartPtr<Apto::Random>(new Apto::RNG::AvidaRNG(1)));
+  
+  // Entries sharing a node, including the first and last, should each receive an equal share
+  for (int i = 0; i < entry_count; i++) sched.AdjustPriority(i, 1.0);
+  Apto::Array<int> counts(entry_count);
+  counts.SetAll(0);
+  for (int i = 0; i < draws; i++) counts[sched.Next()]++;
+  for (int i = 0; i < entry_count; i++) EXPECT_NEAR(draws / entry_count, counts[i], draws / 50);
+  
+  // Priority 3 spans two nodes, and should receive three times the share of priority 1
+  sched.AdjustPriority(0, 3.0);
+  sched.AdjustPriority(1, 0.0);
+  counts.SetAll(0);
+  for (int i = 0; i < draws; i++) counts[sched.Next()]++;
+  EXPECT_EQ(0, counts[1]);
+  EXPECT_NEAR(draws * 3 / 5, counts[0], draws / 50);
+  EXPECT_NEAR(draws / 5, counts[2], draws / 50);
+  EXPECT_NEAR(draws / 5, counts[3], draws / 50);
+}
+
+
+TEST(SchedulerProbabilisticIntegrated, NextBatch) {
+  const int entry_count = 100;
+  Apto::Scheduler::ProbabilisticIntegrated batch_sched(entry_count, Apto::SmartPtr<Apto::Random>(new Apto::RNG::AvidaRNG(7)));
+  Apto::Scheduler::ProbabilisticIntegrated single_sched(entry_count, Apto::SmartPtr<Apto::Random>(new Apto::RNG::AvidaRNG(7)));
+  for (int i = 0; i < entry_count; i++) {
+    batch_sched.AdjustPriority(i, 1 + i % 13);
+    single_sched.AdjustPriority(i, 1 + i % 13);
+  }
+  
+  // Batched draws must match the same number of individual draws
+  Apto::Array<int> entry_ids(1000);
+  batch_sched.NextBatch(entry_ids);
+  for (int i = 0; i < entry_ids.GetSize(); i++) EXPECT_EQ(single_sched.Next(), entry_ids[i]);
+  
+  // ...including after priorities change between batches
+  batch_sched.AdjustPriority(5, 0.0);
+  single_sched.AdjustPriority(5, 0.0);
+  batch_sched.NextBatch(entry_ids);
+  for (int i = 0; i < entry_ids.GetSize(); i++) {
+    EXPECT_NE(5, entry_ids[i]);
+    EXPECT_EQ(single_sched.Next(), entry_ids[i]);
+  }
+}
@@ -155,3 +155,84 @@ TEST(StatAccumulator, StdError) {
   EXPECT_GT(0.76376262, ac.StdError());
 }
 
+
+
+TEST(StatAccumulator, Merge) {
+  // Per-thread style accumulators over interleaved slices reduce to the accumulator of the whole sequence
+  typedef Apto::TL::Create<Apto::Stat::AccumulatorStats::Count, Apto::Stat::AccumulatorStats::Min,
+                           Apto::Stat::AccumulatorStats::Max, Apto::Stat::AccumulatorStats::Sum,
+                           Apto::Stat::AccumulatorStats::StdError,
+                           Apto::Stat::AccumulatorStats::Moment<3> >::Type MergeStats;
+  Apto::Stat::Accumulator<int, MergeStats> whole;
+  Apto::Stat::Accumulator<int, MergeStats> parts[3];
+  for (int i = 0; i < 100; i++) {
+    int value = (i * 37) % 23 - 11;
+    whole.Add(value);
+    parts[i % 3].Add(value);
+  }
+  
+  Apto::Stat::Accumulator<int, MergeStats> merged;
+  Apto::Stat::Accumulator<int, MergeStats> empty;
+  merged.Merge(empty);
+  for (int p = 0; p < 3; p++) merged.Merge(parts[p]);
+  merged.Merge(empty);
+  
+  EXPECT_EQ(whole.Count(), merged.Count());
+  EXPECT_EQ(whole.Min(), merged.Min());
+  EXPECT_EQ(whole.Max(), merged.Max());
+  EXPECT_EQ(whole.Sum(), merged.Sum());
+  EXPECT_EQ(whole.Mean(), merged.Mean());
+  EXPECT_EQ(whole.Variance(), merged.Variance());
+  EXPECT_EQ(whole.StdError(), merged.StdError());
+  EXPECT_EQ(whole.Moment(Apto::Type::Int<3>()), merged.Moment(Apto::Type::Int<3>()));
+  
+  // Empty accumulators of floating point values must not contribute their initial extremes
+  Apto::Stat::Accumulator<double> negative;
+  Apto::Stat::Accumulator<double> none;
+  negative.Add(-2.5);
+  negative.Add(-0.5);
+  negative.Merge(none);
+  EXPECT_EQ(-0.5, negative.Max());
+  EXPECT_EQ(-2.5, negative.Min());
+  EXPECT_EQ(2u, negative.Count());
+}
+
+
+TEST(StatAccumulator, AddBatch) {
+  typedef Apto::TL::Create<Apto::Stat::AccumulatorStats::Count, Apto::Stat::AccumulatorStats::Min,
+                           Apto::Stat::AccumulatorStats::Max, Apto::Stat::AccumulatorStats::StdError,
+                           Apto::Stat::AccumulatorStats::Moment<3> >::Type BatchStats;
+  
+  // Lengths around the unrolled width and the block size, integer results match adding one value at a time exactly
+  int values[5003];
+  for (int i = 0; i < 5003; i++) values[i] = (i * 7919) % 1013 - 500;
+  const int lengths[] = { 0, 1, 3, 4, 7, 2048, 2051, 5003 };
+  for (int l = 0; l < 8; l++) {
+    Apto::Stat::Accumulator<int, BatchStats> single;
+    Apto::Stat::Accumulator<int, BatchStats> batch;
+    single.Add(3);
+    batch.Add(3);
+    for (int i = 0; i < lengths[l]; i++) single.Add(values[i]);
+    batch.AddBatch(values, lengths[l]);
+    
+    EXPECT_EQ(single.Count(), batch.Count());
+    EXPECT_EQ(single.Min(), batch.Min());
+    EXPECT_EQ(single.Max(), batch.Max());
+    EXPECT_EQ(single.Sum(), batch.Sum());
+    EXPECT_EQ(single.Variance(), batch.Variance());
+    EXPECT_EQ(single.Moment(Apto::Type::Int<3>()), batch.Moment(Apto::Type::Int<3>()));
+  }
+  
+  // Floating point sums differ only in rounding
+  double reals[3001];
+  for (int i = 0; i < 3001; i++) reals[i] = -1.0 + 0.001 * ((i * 389) % 2000);
+  Apto::Stat::Accumulator<double> single;
+  Apto::Stat::Accumulator<double> batch;
+  for (int i = 0; i < 3001; i++) single.Add(reals[i]);
+  batch.AddBatch(reals, 3001);
+  EXPECT_EQ(single.Count(), batch.Count());
+  EXPECT_EQ(single.Min(), batch.Min());
+  EXPECT_EQ(single.Max(), batch.Max());
+  EXPECT_NEAR(single.Mean(), batch.Mean(), 1.0e-12);
+  EXPECT_NEAR(single.Variance(), batch.Variance(), 1.0e-12);
+}
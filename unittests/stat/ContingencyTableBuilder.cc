@@ -0,0 +1,122 @@
+/*
+ *  unittests/stat/ContingencyTableBuilder.cc
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#include "apto/stat/ContingencyTableBuilder.h"
+
+#include "apto/core/Array.h"
+
+#include "gtest/gtest.h"
+
+
+TEST(StatContingencyTableBuilder, Counting) {
+  // Reference counts kept one observation at a time
+  const int nrow = 3, ncol = 5;
+  Apto::Array<int> rows(10000);
+  Apto::Array<int> cols(10000);
+  int expected[nrow][ncol] = { { 0 } };
+  for (int i = 0; i < rows.GetSize(); i++) {
+    rows[i] = (i * 7 + i / 13) % nrow;
+    cols[i] = (i * 3 + i / 5) % ncol;
+    expected[rows[i]][cols[i]]++;
+  }
+  
+  // One large batch through the lanes, a short uneven batch counted directly, and single observations
+  Apto::Stat::ContingencyTableBuilder<> builder(nrow, ncol);
+  builder.Add(&rows[0], &cols[0], 9000);
+  builder.Add(&rows[9000], &cols[9000], 37);
+  for (int i = 9037; i < rows.GetSize(); i++) builder.Add(rows[i], cols[i]);
+  
+  EXPECT_EQ(rows.GetSize(), builder.Total());
+  for (int i = 0; i < nrow; i++) {
+    int row_total = 0;
+    for (int j = 0; j < ncol; j++) {
+      EXPECT_EQ(expected[i][j], builder.Count(i, j));
+      row_total += expected[i][j];
+    }
+    EXPECT_EQ(row_total, builder.RowMarginal(i));
+  }
+  for (int j = 0; j < ncol; j++) {
+    int col_total = 0;
+    for (int i = 0; i < nrow; i++) col_total += expected[i][j];
+    EXPECT_EQ(col_total, builder.ColMarginal(j));
+  }
+  
+  Apto::Stat::ContingencyTable table = builder.Build();
+  EXPECT_EQ(nrow, table.NumRows());
+  EXPECT_EQ(ncol, table.NumCols());
+  EXPECT_EQ(rows.GetSize(), table.MarginalTotal());
+  for (int i = 0; i < nrow; i++) {
+    EXPECT_EQ(builder.RowMarginal(i), table.RowMarginals()[i]);
+    for (int j = 0; j < ncol; j++) EXPECT_EQ(expected[i][j], table[i][j]);
+  }
+  for (int j = 0; j < ncol; j++) EXPECT_EQ(builder.ColMarginal(j), table.ColMarginals()[j]);
+  
+  // Built tables behave like any other, and a builder can be reused after clearing
+  table[0][0] = 0;
+  EXPECT_EQ(rows.GetSize() - expected[0][0], table.MarginalTotal());
+  builder.Clear();
+  EXPECT_EQ(0, builder.Total());
+  builder.Build(table);
+  EXPECT_EQ(0, table.MarginalTotal());
+  EXPECT_EQ(0, table[1][1]);
+}
+
+
+TEST(StatContingencyTableBuilder, CellWidths) {
+  Apto::Array<int> rows(5000);
+  Apto::Array<int> cols(5000);
+  for (int i = 0; i < rows.GetSize(); i++) {
+    rows[i] = i % 2;
+    cols[i] = (i / 2) % 2;
+  }
+  
+  Apto::Stat::ContingencyTableBuilder<uint16_t> compact(2, 2);
+  Apto::Stat::ContingencyTableBuilder<int64_t> wide(2, 2);
+  for (int pass = 0; pass < 4; pass++) {
+    compact.Add(&rows[0], &cols[0], rows.GetSize());
+    wide.Add(&rows[0], &cols[0], rows.GetSize());
+  }
+  for (int i = 0; i < 2; i++) for (int j = 0; j < 2; j++) {
+    EXPECT_EQ(5000, compact.Count(i, j));
+    EXPECT_EQ(5000, wide.Count(i, j));
+  }
+  EXPECT_EQ(20000, compact.Total());
+  
+  // Single observations update the marginals alongside the batches
+  wide.Add(0, 0);
+  EXPECT_EQ(5001, wide.Count(0, 0));
+  EXPECT_EQ(10001, wide.RowMarginal(0));
+  EXPECT_EQ(10001, wide.ColMarginal(0));
+  EXPECT_EQ(20001, wide.Total());
+  
+  Apto::Stat::ContingencyTable table = compact.Build();
+  EXPECT_EQ(20000, table.MarginalTotal());
+  EXPECT_EQ(5000, table[1][0]);
+}
@@ -31,8 +31,12 @@
 #include "apto/stat/ContingencyTable.h"
 #include "apto/stat/Functions.h"
 
+#include "apto/core/Thread.h"
+#include "apto/rng/Xoshiro256StarStar.h"
+
 #include "gtest/gtest.h"
 
+#include <cmath>
 #include <iostream>
 
 
@@ -224,3 +228,308 @@ TEST(StatFunctions, FishersExact) {
   EXPECT_LT(.159961169e-11, pvalue);
   EXPECT_GT(.159961170e-11, pvalue);  
 }
+
+
+TEST(StatFunctions, FishersExact2x2) {
+  // Reference values summed from exact hypergeometric probabilities
+  EXPECT_NEAR(0.428571428571, Apto::Stat::FishersExact2x2(2, 2, 4, 0), 1.0e-12);
+  EXPECT_NEAR(0.485714285714, Apto::Stat::FishersExact2x2(3, 1, 1, 3), 1.0e-12);
+  EXPECT_NEAR(1.08250882245e-5, Apto::Stat::FishersExact2x2(0, 10, 10, 0), 1.0e-16);
+  EXPECT_NEAR(3.15161668668e-4, Apto::Stat::FishersExact2x2(120, 80, 95, 130), 1.0e-14);
+  EXPECT_NEAR(7.86285016111e-5, Apto::Stat::FishersExact2x2(1000, 900, 950, 1100), 1.0e-12);
+  EXPECT_NEAR(1.0, Apto::Stat::FishersExact2x2(1, 0, 0, 0), 1.0e-12);
+  double pvalue = Apto::Stat::FishersExact2x2(0, 0, 0, 0);
+  EXPECT_NE(pvalue, pvalue);
+  
+  Apto::Stat::ContingencyTable table(2, 2);
+  table[0][0] = 120; table[0][1] = 80;
+  table[1][0] = 95;  table[1][1] = 130;
+  EXPECT_EQ(Apto::Stat::FishersExact2x2(120, 80, 95, 130), Apto::Stat::FishersExact(table));
+  
+  const int cells[] = { 2, 2, 4, 0,  3, 1, 1, 3,  0, 0, 0, 0,  120, 80, 95, 130 };
+  double pvalues[4];
+  Apto::Stat::FishersExact2x2(cells, pvalues, 4);
+  for (int t = 0; t < 4; t++) {
+    double expected = Apto::Stat::FishersExact2x2(cells[4 * t], cells[4 * t + 1], cells[4 * t + 2], cells[4 * t + 3]);
+    if (t == 2) EXPECT_NE(pvalues[t], pvalues[t]);
+    else EXPECT_EQ(expected, pvalues[t]);
+  }
+  
+  // Tables with two columns are summed as their transpose
+  Apto::Stat::ContingencyTable wide(2, 4);
+  Apto::Stat::ContingencyTable tall(4, 2);
+  const int row0[] = { 10, 5, 12, 3 }, row1[] = { 4, 9, 6, 11 };
+  for (int j = 0; j < 4; j++) {
+    wide[0][j] = row0[j]; wide[1][j] = row1[j];
+    tall[j][0] = row0[j]; tall[j][1] = row1[j];
+  }
+  EXPECT_NEAR(0.0191679831635, Apto::Stat::FishersExact(wide), 1.0e-12);
+  EXPECT_EQ(Apto::Stat::FishersExact(wide), Apto::Stat::FishersExact(tall));
+}
+
+
+TEST(StatFunctions, FishersExactBatch) {
+  Apto::Array<Apto::Stat::ContingencyTable> tables(40);
+  for (int t = 0; t < tables.GetSize(); t++) {
+    switch (t % 4) {
+      case 0:
+        // Small tables, calculated across the worker pool
+        tables[t] = Apto::Stat::ContingencyTable(2, 2);
+        tables[t][0][0] = 2 + t; tables[t][0][1] = 2;
+        tables[t][1][0] = 4;     tables[t][1][1] = t % 3;
+        break;
+        
+      case 1:
+        tables[t] = Apto::Stat::ContingencyTable(3, 3);
+        tables[t][0][0] = 2; tables[t][0][1] = 4; tables[t][0][2] = 6;
+        tables[t][1][0] = 7; tables[t][1][1] = 6; tables[t][1][2] = 1 + t % 5;
+        tables[t][2][0] = 5; tables[t][2][1] = 0; tables[t][2][2] = 0;
+        break;
+        
+      case 2:
+        // Large tables, calculated one at a time with the pool working within the table
+        tables[t] = Apto::Stat::ContingencyTable(4, 6);
+        for (int i = 0; i < 4; i++) for (int j = 0; j < 6; j++) tables[t][i][j] = (i * 7 + j * 3 + t) % 5;
+        break;
+        
+      default:
+        // Empty tables have no p-value
+        break;
+    }
+  }
+  
+  Apto::Array<double> pvalues;
+  Apto::Stat::FishersExact(tables, pvalues);
+  ASSERT_EQ(tables.GetSize(), pvalues.GetSize());
+  for (int t = 0; t < tables.GetSize(); t++) {
+    if (t % 4 == 3) {
+      EXPECT_NE(pvalues[t], pvalues[t]);
+    } else {
+      // Threaded calculation of large tables may sum paths in a different order
+      double expected = Apto::Stat::FishersExact(tables[t]);
+      EXPECT_NEAR(expected, pvalues[t], expected * 1.0e-9);
+    }
+  }
+  
+  // Repeated batches reuse the same pool
+  Apto::Array<double> again;
+  Apto::Stat::FishersExact(tables, again);
+  for (int t = 0; t < tables.GetSize(); t += 4) EXPECT_EQ(pvalues[t], again[t]);  // small tables are exact
+}
+
+
+TEST(StatFunctions, FishersExactLargeKeys) {
+  // Reference p-values from full enumeration of the tables sharing these marginals
+  
+  // Row marginal keys overflow int, packed into 64 bits
+  Apto::Stat::ContingencyTable t1(3,3);
+  t1[0][0] = 0; t1[0][1] =     1; t1[0][2] =     0;
+  t1[1][0] = 0; t1[1][1] = 20300; t1[1][2] = 19700;
+  t1[2][0] = 5; t1[2][1] = 29800; t1[2][2] = 30200;
+  
+  double pvalue = Apto::Stat::FishersExact(t1);
+  EXPECT_NEAR(0.000417512516, pvalue, 0.000417512516 * 2.0e-6);
+  
+  
+  // Row marginal keys overflow 64 bits, interned
+  Apto::Stat::ContingencyTable t2(4,4);
+  t2[0][0] = 0; t2[0][1] = 0; t2[0][2] = 1; t2[0][3] = 59999;
+  t2[1][0] = 0; t2[1][1] = 1; t2[1][2] = 0; t2[1][3] = 60000;
+  t2[2][0] = 1; t2[2][1] = 0; t2[2][2] = 2; t2[2][3] = 60001;
+  t2[3][0] = 1; t2[3][1] = 2; t2[3][2] = 1; t2[3][3] = 60002;
+  
+  pvalue = Apto::Stat::FishersExact(t2);
+  EXPECT_NEAR(0.765709983, pvalue, 0.765709983 * 2.0e-6);
+}
+
+
+class FishersExactCaller : public Apto::Thread
+{
+private:
+  const Apto::Stat::ContingencyTable& m_table;
+  int m_repeats;
+  double m_min_pvalue;
+  double m_max_pvalue;
+  
+public:
+  FishersExactCaller(const Apto::Stat::ContingencyTable& table, int repeats)
+    : m_table(table), m_repeats(repeats), m_min_pvalue(1.0), m_max_pvalue(0.0) { ; }
+  
+  double MinPValue() const { return m_min_pvalue; }
+  double MaxPValue() const { return m_max_pvalue; }
+  
+protected:
+  void Run()
+  {
+    for (int i = 0; i < m_repeats; i++) {
+      double pvalue = Apto::Stat::FishersExact(m_table);
+      if (pvalue < m_min_pvalue) m_min_pvalue = pvalue;
+      if (pvalue > m_max_pvalue) m_max_pvalue = pvalue;
+    }
+  }
+};
+
+
+TEST(StatFunctions, FishersExactConcurrentCallers) {
+  // Large tables from several threads at once share the worker pool, each caller must finish with its own result
+  Apto::Stat::ContingencyTable t1(5,6);
+  t1[0][0] = 1; t1[0][1] = 2; t1[0][2] = 2; t1[0][3] = 1; t1[0][4] = 1; t1[0][5] = 0;
+  t1[1][0] = 2; t1[1][1] = 0; t1[1][2] = 0; t1[1][3] = 2; t1[1][4] = 3; t1[1][5] = 0;
+  t1[2][0] = 0; t1[2][1] = 1; t1[2][2] = 1; t1[2][3] = 1; t1[2][4] = 2; t1[2][5] = 7;
+  t1[3][0] = 1; t1[3][1] = 1; t1[3][2] = 2; t1[3][3] = 0; t1[3][4] = 0; t1[3][5] = 0;
+  t1[4][0] = 0; t1[4][1] = 1; t1[4][2] = 1; t1[4][3] = 1; t1[4][4] = 1; t1[4][5] = 0;
+  
+  Apto::Stat::ContingencyTable t2(4,6);
+  t2[0][0] = 2; t2[0][1] = 0; t2[0][2] = 1; t2[0][3] = 2; t2[0][4] = 6; t2[0][5] = 5;
+  t2[1][0] = 1; t2[1][1] = 3; t2[1][2] = 1; t2[1][3] = 1; t2[1][4] = 1; t2[1][5] = 2;
+  t2[2][0] = 1; t2[2][1] = 0; t2[2][2] = 3; t2[2][3] = 1; t2[2][4] = 0; t2[2][5] = 0;
+  t2[3][0] = 1; t2[3][1] = 2; t2[3][2] = 1; t2[3][3] = 2; t2[3][4] = 0; t2[3][5] = 0;
+  
+  FishersExactCaller* callers[4];
+  for (int i = 0; i < 4; i++) {
+    callers[i] = new FishersExactCaller((i & 1) ? t2 : t1, 3);
+    callers[i]->Start();
+  }
+  for (int i = 0; i < 4; i++) {
+    callers[i]->Join();
+    if (i & 1) {
+      EXPECT_LT(.0453742835, callers[i]->MinPValue());
+      EXPECT_GT(.0453742836, callers[i]->MaxPValue());
+    } else {
+      EXPECT_LT(.0258388679, callers[i]->MinPValue());
+      EXPECT_GT(.0258388680, callers[i]->MaxPValue());
+    }
+    delete callers[i];
+  }
+}
+
+TEST(StatFunctions, FishersExactMonteCarlo) {
+  Apto::Stat::ContingencyTable t1(4,5);
+  t1[0][0] = 2; t1[0][1] = 0; t1[0][2] = 1; t1[0][3] = 2; t1[0][4] = 6;
+  t1[1][0] = 1; t1[1][1] = 3; t1[1][2] = 1; t1[1][3] = 1; t1[1][4] = 1;
+  t1[2][0] = 1; t1[2][1] = 0; t1[2][2] = 3; t1[2][3] = 1; t1[2][4] = 0;
+  t1[3][0] = 1; t1[3][1] = 2; t1[3][2] = 1; t1[3][3] = 2; t1[3][4] = 0;
+  const double exact = .0911177720;
+  
+  // Sampling stops once the confidence interval is narrow enough, and the estimate lies within it
+  Apto::RNG::Xoshiro256StarStar rng(2013);
+  double std_error = 0.0;
+  double estimate = Apto::Stat::FishersExactMonteCarlo(t1, rng, std_error, 0.005);
+  EXPECT_GE(0.005, 2.0 * 1.959964 * std_error);
+  EXPECT_LT(0.0, std_error);
+  EXPECT_NEAR(exact, estimate, 4.0 * std_error);
+  
+  // Identical generators give identical estimates, and repeated calls on one generator sample afresh
+  Apto::RNG::Xoshiro256StarStar twin(2013);
+  double twin_error = 0.0;
+  EXPECT_EQ(estimate, Apto::Stat::FishersExactMonteCarlo(t1, twin, twin_error, 0.005));
+  EXPECT_EQ(std_error, twin_error);
+  EXPECT_NE(estimate, Apto::Stat::FishersExactMonteCarlo(t1, twin, twin_error, 0.005));
+  
+  // The sample limit bounds the work, whatever the requested width
+  double limited = Apto::Stat::FishersExactMonteCarlo(t1, rng, std_error, 0.0, 1000);
+  EXPECT_NEAR(sqrt(exact * (1.0 - exact) / 1000), std_error, 0.003);
+  EXPECT_NEAR(exact, limited, 4.0 * std_error);
+  
+  // Tables where every arrangement is as extreme as the observed one
+  Apto::Stat::ContingencyTable t2(2,2);
+  t2[0][0] = 1; t2[0][1] = 1;
+  t2[1][0] = 1; t2[1][1] = 1;
+  EXPECT_EQ(1.0, Apto::Stat::FishersExactMonteCarlo(t2, rng, std_error, 0.01));
+  
+  Apto::Stat::ContingencyTable empty(2,2);
+  double empty_pvalue = Apto::Stat::FishersExactMonteCarlo(empty, rng, std_error);
+  EXPECT_NE(empty_pvalue, empty_pvalue);
+}
+
+
+TEST(StatFunctions, ContingencyTests) {
+  Apto::Array<Apto::Stat::ContingencyTable> tables(5);
+  tables[0] = Apto::Stat::ContingencyTable(2, 2);
+  tables[0][0][0] = 12; tables[0][0][1] = 5;
+  tables[0][1][0] = 7;  tables[0][1][1] = 14;
+  
+  tables[1] = Apto::Stat::ContingencyTable(2, 3);
+  tables[1][0][0] = 10; tables[1][0][1] = 20; tables[1][0][2] = 30;
+  tables[1][1][0] = 25; tables[1][1][1] = 15; tables[1][1][2] = 12;
+  
+  tables[2] = Apto::Stat::ContingencyTable(3, 3);
+  tables[2][0][0] = 2; tables[2][0][1] = 4; tables[2][0][2] = 6;
+  tables[2][1][0] = 7; tables[2][1][1] = 6; tables[2][1][2] = 1;
+  tables[2][2][0] = 5; tables[2][2][1] = 0; tables[2][2][2] = 0;
+  
+  // An empty row leaves the degrees of freedom
+  tables[3] = Apto::Stat::ContingencyTable(3, 2);
+  tables[3][0][0] = 3; tables[3][0][1] = 0;
+  tables[3][2][0] = 1; tables[3][2][1] = 4;
+  
+  // Reference statistics and p-values from the closed forms of the chi-square distribution for 1, 2 and 4 degrees
+  // of freedom, mid-p values from exact enumeration
+  const int df[] = { 1, 2, 4, 1 };
+  const double chi_square[] = { 5.215686274509804, 14.35897435897436, 14.266326530612245, 4.8 };
+  const double chi_square_pvalue[] = { 0.02238401069217774, 0.0007620585412149424, 0.006491813665607587,
+                                       0.02845973691631057 };
+  const double g[] = { 5.348475675515369, 14.755968999818018, 16.29570563750389, 6.086330653577246 };
+  const double g_pvalue[] = { 0.020740395343242065, 0.000624859021101721, 0.0026469860347754248,
+                              0.013623172272003646 };
+  for (int t = 0; t < 4; t++) {
+    EXPECT_NEAR(chi_square_pvalue[t], Apto::Stat::ChiSquareTest(tables[t]), chi_square_pvalue[t] * 1.0e-10);
+    EXPECT_NEAR(g_pvalue[t], Apto::Stat::GTest(tables[t]), g_pvalue[t] * 1.0e-10);
+  }
+  EXPECT_NEAR(0.028495627750838855, Apto::Stat::FishersExactMidP(tables[0]), 1.0e-12);
+  EXPECT_NEAR(0.007286254173089892, Apto::Stat::FishersExactMidP(tables[2]), 1.0e-10);
+  
+  // The table at the other extreme is exactly as probable as the observed table, both count at half weight
+  Apto::Stat::ContingencyTable tied(2, 2);
+  tied[0][0] = 2; tied[0][1] = 2;
+  tied[1][0] = 4; tied[1][1] = 0;
+  EXPECT_NEAR(0.214285714285714, Apto::Stat::FishersExactMidP(tied), 1.0e-12);
+  
+  // Ties summed by the 2 x c network, by FExact and by the threaded FExact, against full enumeration of the tables
+  Apto::Array<Apto::Stat::ContingencyTable> exact(3);
+  exact[0] = Apto::Stat::ContingencyTable(2, 4);
+  exact[0][0][0] = 3; exact[0][0][1] = 1; exact[0][0][2] = 4; exact[0][0][3] = 1;
+  exact[0][1][0] = 1; exact[0][1][1] = 4; exact[0][1][2] = 1; exact[0][1][3] = 3;
+  exact[1] = Apto::Stat::ContingencyTable(4, 5);
+  exact[1][0][0] = 2; exact[1][0][1] = 0; exact[1][0][2] = 1; exact[1][0][3] = 2; exact[1][0][4] = 6;
+  exact[1][1][0] = 1; exact[1][1][1] = 3; exact[1][1][2] = 1; exact[1][1][3] = 1; exact[1][1][4] = 1;
+  exact[1][2][0] = 1; exact[1][2][1] = 0; exact[1][2][2] = 3; exact[1][2][3] = 1; exact[1][2][4] = 0;
+  exact[1][3][0] = 1; exact[1][3][1] = 2; exact[1][3][2] = 1; exact[1][3][3] = 2; exact[1][3][4] = 0;
+  const int threaded_cells[3][7] = { { 1, 0, 2, 0, 1, 0, 1 }, { 0, 1, 0, 1, 0, 2, 0 }, { 1, 1, 0, 1, 1, 0, 2 } };
+  exact[2] = Apto::Stat::ContingencyTable(3, 7);
+  for (int i = 0; i < 3; i++) for (int j = 0; j < 7; j++) exact[2][i][j] = threaded_cells[i][j];
+  const double exact_mid_p[] = { 0.189633895516247, 0.0877074331786253, 0.377955377955353 };
+  
+  Apto::Array<double> batch_mid_p;
+  Apto::Stat::FishersExactMidP(exact, batch_mid_p);
+  ASSERT_EQ(exact.GetSize(), batch_mid_p.GetSize());
+  for (int t = 0; t < exact.GetSize(); t++) {
+    EXPECT_NEAR(exact_mid_p[t], Apto::Stat::FishersExactMidP(exact[t]), exact_mid_p[t] * 1.0e-9);
+    EXPECT_NEAR(exact_mid_p[t], batch_mid_p[t], exact_mid_p[t] * 1.0e-9);
+  }
+  
+  Apto::Stat::ContingencyTable large(3, 3);
+  large[0][0] = 300; large[0][1] = 200; large[0][2] = 150;
+  large[1][0] = 250; large[1][1] = 310; large[1][2] = 180;
+  large[2][0] = 90;  large[2][1] = 40;  large[2][2] = 160;
+  EXPECT_NEAR(9.970193493518728e-32, Apto::Stat::ChiSquareTest(large), 9.970193493518728e-32 * 1.0e-9);
+  EXPECT_NEAR(1.9216314416617766e-30, Apto::Stat::GTest(large), 1.9216314416617766e-30 * 1.0e-9);
+  
+  // The batch matches the individual tests, running the exact test only where either approximate p-value qualifies
+  Apto::Array<Apto::Stat::ContingencyTestResult> results;
+  Apto::Stat::ContingencyTests(tables, results, 0.01);
+  ASSERT_EQ(tables.GetSize(), results.GetSize());
+  for (int t = 0; t < 4; t++) {
+    EXPECT_EQ(df[t], results[t].df);
+    EXPECT_NEAR(chi_square[t], results[t].chi_square, chi_square[t] * 1.0e-12);
+    EXPECT_NEAR(g[t], results[t].g, g[t] * 1.0e-12);
+    EXPECT_EQ(Apto::Stat::ChiSquareTest(tables[t]), results[t].chi_square_pvalue);
+    EXPECT_EQ(Apto::Stat::GTest(tables[t]), results[t].g_pvalue);
+  }
+  EXPECT_NE(results[0].mid_p, results[0].mid_p);
+  EXPECT_EQ(Apto::Stat::FishersExactMidP(tables[1]), results[1].mid_p);
+  EXPECT_EQ(Apto::Stat::FishersExactMidP(tables[2]), results[2].mid_p);
+  EXPECT_NE(results[3].mid_p, results[3].mid_p);
+  EXPECT_NE(results[4].g_pvalue, results[4].g_pvalue);
+  EXPECT_NE(results[4].mid_p, results[4].mid_p);
+}
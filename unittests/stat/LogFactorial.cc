@@ -0,0 +1,100 @@
+/*
+ *  unittests/stat/LogFactorial.cc
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#include "apto/stat/LogFactorial.h"
+
+#include "apto/core/Thread.h"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+
+
+class LogFactorialReader : public Apto::Thread
+{
+private:
+  int m_max;
+  bool m_matched;
+  
+public:
+  LogFactorialReader(int max) : m_max(max), m_matched(false) { ; }
+  
+  bool Matched() const { return m_matched; }
+  
+protected:
+  void Run()
+  {
+    m_matched = true;
+    for (int n = 0; n <= m_max; n += 97) {
+      if (std::fabs(Apto::Stat::LogFactorial(n) - lgamma(n + 1.0)) > 1.0e-9 * (1.0 + lgamma(n + 1.0))) {
+        m_matched = false;
+      }
+    }
+  }
+};
+
+
+TEST(StatLogFactorial, Values) {
+  EXPECT_EQ(0.0, Apto::Stat::LogFactorial(0));
+  EXPECT_EQ(0.0, Apto::Stat::LogFactorial(1));
+  EXPECT_NEAR(log(2.0), Apto::Stat::LogFactorial(2), 1.0e-15);
+  EXPECT_NEAR(log(120.0), Apto::Stat::LogFactorial(5), 1.0e-13);
+  EXPECT_NEAR(log(3628800.0), Apto::Stat::LogFactorial(10), 1.0e-12);
+  
+  const double* facts = Apto::Stat::LogFactorials(5000);
+  for (int n = 2; n <= 5000; n++) EXPECT_NEAR(lgamma(n + 1.0), facts[n], 1.0e-9 * lgamma(n + 1.0));
+}
+
+
+TEST(StatLogFactorial, Growth) {
+  const double* small = Apto::Stat::LogFactorials(10);
+  double small_value = small[10];
+  
+  // A covered request returns the current table without growing it
+  EXPECT_EQ(Apto::Stat::LogFactorials(10), Apto::Stat::LogFactorials(9));
+  
+  // Growing leaves tables handed out earlier intact, and extends them with identical values
+  const double* large = Apto::Stat::LogFactorials(200000);
+  EXPECT_EQ(small_value, small[10]);
+  EXPECT_EQ(small_value, large[10]);
+  EXPECT_NEAR(lgamma(200001.0), large[200000], 1.0e-9 * lgamma(200001.0));
+  
+  // Concurrent readers racing to grow the table all see correct values
+  LogFactorialReader* readers[4];
+  for (int i = 0; i < 4; i++) {
+    readers[i] = new LogFactorialReader(400000 + i * 150000);
+    readers[i]->Start();
+  }
+  for (int i = 0; i < 4; i++) {
+    readers[i]->Join();
+    EXPECT_TRUE(readers[i]->Matched());
+    delete readers[i];
+  }
+}
@@ -0,0 +1,121 @@
+/*
+ *  utils/benchmark/Benchmark.cc
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#include "Benchmark.h"
+
+#include "apto/core/SmartPtr.h"
+#include "apto/rng/AvidaRNG.h"
+#include "apto/scheduler.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+
+
+static std::atomic<std::size_t> s_allocated(0);
+static std::atomic<std::size_t> s_peak(0);
+static volatile long long s_sink_int = 0;
+static volatile double s_sink_double = 0.0;
+
+// Shape of the skewed priority distribution
+static const double PARETO_ALPHA = 1.16;
+
+// Each allocation is prefixed with its size so that deallocations can be accounted for
+static const std::size_t HEADER_SIZE = 16;
+
+
+static void* trackedAlloc(std::size_t size)
+{
+  char* block = static_cast<char*>(malloc(size + HEADER_SIZE));
+  if (!block) throw std::bad_alloc();
+  *reinterpret_cast<std::size_t*>(block) = size;
+  
+  std::size_t current = (s_allocated += size);
+  std::size_t peak = s_peak.load();
+  while (current > peak && !s_peak.compare_exchange_weak(peak, current)) ;
+  
+  return block + HEADER_SIZE;
+}
+
+static void trackedFree(void* ptr)
+{
+  if (!ptr) return;
+  char* block = static_cast<char*>(ptr) - HEADER_SIZE;
+  s_allocated -= *reinterpret_cast<std::size_t*>(block);
+  free(block);
+}
+
+
+void* operator new(std::size_t size) { return trackedAlloc(size); }
+void* operator new[](std::size_t size) { return trackedAlloc(size); }
+void operator delete(void* ptr) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr) noexcept { trackedFree(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { trackedFree(ptr); }
+
+
+std::size_t Benchmark::AllocatedBytes() { return s_allocated.load(); }
+std::size_t Benchmark::PeakAllocatedBytes() { return s_peak.load(); }
+void Benchmark::ResetPeakAllocatedBytes() { s_peak.store(s_allocated.load()); }
+
+void Benchmark::Sink(long long value) { s_sink_int = s_sink_int + value; }
+void Benchmark::Sink(double value) { s_sink_double = s_sink_double + value; }
+
+
+const char* const Benchmark::SCHEDULER_NAMES[] = {
+  "RoundRobin", "Integrated", "Probabilistic", "ProbabilisticIntegrated"
+};
+const char* const Benchmark::DISTRIBUTION_NAMES[] = { "uniform", "skewed" };
+
+
+Apto::PriorityScheduler* Benchmark::CreateScheduler(SchedulerType type, int entry_count, int seed)
+{
+  Apto::SmartPtr<Apto::Random> rng(new Apto::RNG::AvidaRNG(seed));
+  switch (type) {
+    case ROUND_ROBIN:               return new Apto::Scheduler::RoundRobin(entry_count);
+    case INTEGRATED:                return new Apto::Scheduler::Integrated(entry_count);
+    case PROBABILISTIC:             return new Apto::Scheduler::Probabilistic(entry_count, rng);
+    case PROBABILISTIC_INTEGRATED:  return new Apto::Scheduler::ProbabilisticIntegrated(entry_count, rng);
+    default:                        return NULL;
+  }
+}
+
+double Benchmark::DrawPriority(Apto::Random& rng, Distribution dist, double uniform_max, double skewed_max,
+                               bool whole_numbers)
+{
+  if (dist == UNIFORM) {
+    return (whole_numbers) ? 1 + rng.GetInt(static_cast<int>(uniform_max)) : rng.GetDouble(1.0, uniform_max);
+  }
+  
+  double priority = pow(1.0 - rng.GetDouble(), -1.0 / PARETO_ALPHA);
+  if (whole_numbers) priority = floor(priority);
+  return (priority < skewed_max) ? priority : skewed_max;
+}
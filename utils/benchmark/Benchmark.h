@@ -0,0 +1,95 @@
+/*
+ *  utils/benchmark/Benchmark.h
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#ifndef AptoBenchmark_h
+#define AptoBenchmark_h
+
+#include "apto/core/PriorityScheduler.h"
+#include "apto/core/Random.h"
+
+#include <chrono>
+#include <cstddef>
+
+
+namespace Benchmark {
+  
+  // Timer - wall clock timer for measuring per-operation cost
+  // --------------------------------------------------------------------------------------------------------------
+  
+  class Timer
+  {
+  private:
+    std::chrono::steady_clock::time_point m_start;
+    
+  public:
+    inline Timer() : m_start(std::chrono::steady_clock::now()) { ; }
+    
+    inline void Start() { m_start = std::chrono::steady_clock::now(); }
+    inline double ElapsedNS() const
+    {
+      return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - m_start).count();
+    }
+    inline double NSPerOp(double ops) const { return ElapsedNS() / ops; }
+  };
+  
+  
+  // Heap Tracking - all operator new/delete calls within the benchmark executable are counted
+  // --------------------------------------------------------------------------------------------------------------
+  
+  std::size_t AllocatedBytes();
+  std::size_t PeakAllocatedBytes();
+  void ResetPeakAllocatedBytes();
+  
+  
+  // Sink - consumes a value so that benchmark loops are not optimized away
+  // --------------------------------------------------------------------------------------------------------------
+  
+  void Sink(long long value);
+  void Sink(double value);
+  
+  
+  // Schedulers - the scheduler implementations and priority distributions shared by the scheduler benchmarks
+  // --------------------------------------------------------------------------------------------------------------
+  
+  enum SchedulerType { ROUND_ROBIN, INTEGRATED, PROBABILISTIC, PROBABILISTIC_INTEGRATED, NUM_SCHEDULER_TYPES };
+  enum Distribution { UNIFORM, SKEWED, NUM_DISTRIBUTIONS };
+  
+  extern const char* const SCHEDULER_NAMES[NUM_SCHEDULER_TYPES];
+  extern const char* const DISTRIBUTION_NAMES[NUM_DISTRIBUTIONS];
+  
+  // Probabilistic schedulers draw from an AvidaRNG seeded with seed
+  Apto::PriorityScheduler* CreateScheduler(SchedulerType type, int entry_count, int seed);
+  
+  // Uniform priorities fall in [1, uniform_max], skewed ones follow a Pareto distribution (roughly 80/20) capped at
+  // skewed_max. With whole_numbers set, priorities are integral.
+  double DrawPriority(Apto::Random& rng, Distribution dist, double uniform_max, double skewed_max, bool whole_numbers);
+};
+
+#endif
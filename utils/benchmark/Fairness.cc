@@ -0,0 +1,169 @@
+/*
+ *  utils/benchmark/Fairness.cc
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#include "Benchmark.h"
+
+#include "apto/core/Array.h"
+#include "apto/rng/AvidaRNG.h"
+#include "apto/stat/Accumulator.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+// Default settings, overridable from the command line
+static const int DEFAULT_ENTRIES = 1000;
+static const int DEFAULT_SLICES_PER_ENTRY = 1000;
+static const double DEFAULT_MAX_Z = 4.0;
+
+// Priorities are whole numbers so that the bit decomposition used by the integrated schedulers is exact
+static const double UNIFORM_MAX_PRIORITY = 100.0;
+static const double SKEWED_MAX_PRIORITY = 10000.0;
+
+
+static double DrawPriority(Apto::Random& rng, Benchmark::Distribution dist)
+{
+  return Benchmark::DrawPriority(rng, dist, UNIFORM_MAX_PRIORITY, SKEWED_MAX_PRIORITY, true);
+}
+
+
+// CheckFairness - run a scheduler for a number of slices and compare observed counts against expected shares
+// --------------------------------------------------------------------------------------------------------------
+//
+// Each entry's standardized residual (observed - expected) / sqrt(expected) is fed into an accumulator. The
+// chi-square statistic is the sum of the squared residuals, which is recovered from the residual mean and
+// population variance. With k entries the statistic has k - 1 degrees of freedom, and for large k it is
+// approximately normal with mean k - 1 and variance 2(k - 1), which gives the z-score used to pass or fail.
+
+static bool CheckFairness(Benchmark::SchedulerType type, Benchmark::Distribution dist, int entry_count, int slices,
+                          double max_z, int seed)
+{
+  Apto::RNG::AvidaRNG rng(seed);
+  Apto::Array<double> priority(entry_count);
+  for (int i = 0; i < entry_count; i++) priority[i] = DrawPriority(rng, dist);
+  
+  Apto::PriorityScheduler* sched = Benchmark::CreateScheduler(type, entry_count, seed);
+  for (int i = 0; i < entry_count; i++) sched->AdjustPriority(i, priority[i]);
+  
+  Apto::Array<int> counts(entry_count);
+  counts.SetAll(0);
+  for (int i = 0; i < slices; i++) {
+    int entry_id = sched->Next();
+    if (entry_id >= 0 && entry_id < entry_count) counts[entry_id]++;
+  }
+  delete sched;
+  
+  // RoundRobin is priority agnostic, so every active entry is expected to receive an equal share
+  double total_priority = 0.0;
+  for (int i = 0; i < entry_count; i++) total_priority += (type == Benchmark::ROUND_ROBIN) ? 1.0 : priority[i];
+  
+  Apto::Stat::Accumulator<double> residuals;
+  Apto::Stat::Accumulator<double> relative;
+  for (int i = 0; i < entry_count; i++) {
+    double share = ((type == Benchmark::ROUND_ROBIN) ? 1.0 : priority[i]) / total_priority;
+    double expected = share * slices;
+    residuals.Add((counts[i] - expected) / sqrt(expected));
+    relative.Add(fabs(counts[i] - expected) / expected);
+  }
+  
+  double chi_square = residuals.Count() * (residuals.Variance() + residuals.Mean() * residuals.Mean());
+  double df = entry_count - 1;
+  double z = (chi_square - df) / sqrt(2.0 * df);
+  double worst_residual = (-residuals.Min() > residuals.Max()) ? -residuals.Min() : residuals.Max();
+  bool pass = (z <= max_z);
+  
+  printf("%-24s %-8s %8d %12.1f %8.0f %8.2f %10.2f %10.4f %10.4f  %s\n",
+         Benchmark::SCHEDULER_NAMES[type], Benchmark::DISTRIBUTION_NAMES[dist],
+         entry_count, chi_square, df, z, worst_residual, relative.Mean(), relative.Max(), pass ? "ok" : "FAIL");
+  fflush(stdout);
+  
+  return pass;
+}
+
+
+static void Usage(const char* name)
+{
+  fprintf(stderr, "Usage: %s [-entries count] [-slices count] [-maxz z] [-seed seed] [-only scheduler]\n", name);
+  fprintf(stderr, "  slices defaults to %d per entry; a run fails when the chi-square z-score exceeds -maxz (default %g)\n",
+          DEFAULT_SLICES_PER_ENTRY, DEFAULT_MAX_Z);
+}
+
+
+int main(int argc, char* argv[])
+{
+  int entry_count = DEFAULT_ENTRIES;
+  int slices = -1;
+  double max_z = DEFAULT_MAX_Z;
+  int seed = 1;
+  int only = -1;
+  
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 < argc && strcmp(argv[i], "-entries") == 0) entry_count = atoi(argv[++i]);
+    else if (i + 1 < argc && strcmp(argv[i], "-slices") == 0) slices = atoi(argv[++i]);
+    else if (i + 1 < argc && strcmp(argv[i], "-maxz") == 0) max_z = atof(argv[++i]);
+    else if (i + 1 < argc && strcmp(argv[i], "-seed") == 0) seed = atoi(argv[++i]);
+    else if (i + 1 < argc && strcmp(argv[i], "-only") == 0) {
+      const char* name = argv[++i];
+      for (int t = 0; t < Benchmark::NUM_SCHEDULER_TYPES; t++) {
+        if (strcmp(name, Benchmark::SCHEDULER_NAMES[t]) == 0) only = t;
+      }
+      if (only == -1) {
+        Usage(argv[0]);
+        return 1;
+      }
+    } else {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+  if (entry_count < 2) {
+    Usage(argv[0]);
+    return 1;
+  }
+  if (slices <= 0) slices = entry_count * DEFAULT_SLICES_PER_ENTRY;
+  
+  printf("%-24s %-8s %8s %12s %8s %8s %10s %10s %10s\n", "scheduler", "dist", "entries",
+         "chi-square", "df", "z", "worst res", "mean rel", "worst rel");
+  
+  bool all_pass = true;
+  for (int t = 0; t < Benchmark::NUM_SCHEDULER_TYPES; t++) {
+    if (only != -1 && t != only) continue;
+    for (int d = 0; d < Benchmark::NUM_DISTRIBUTIONS; d++) {
+      Benchmark::SchedulerType type = static_cast<Benchmark::SchedulerType>(t);
+      if (!CheckFairness(type, static_cast<Benchmark::Distribution>(d), entry_count, slices, max_z, seed)) {
+        all_pass = false;
+      }
+    }
+  }
+  
+  return all_pass ? 0 : 1;
+}
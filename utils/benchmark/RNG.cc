@@ -0,0 +1,373 @@
+/*
+ *  utils/benchmark/RNG.cc
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#include "Benchmark.h"
+
+#include "apto/core/Array.h"
+#include "apto/rng.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+// Default settings, overridable from the command line
+static const int DEFAULT_OPS = 1000000;
+static const int DEFAULT_QUALITY_DRAWS = 4000000;
+static const double DEFAULT_MAX_Z = 5.0;
+
+// Bulk methods fill a buffer of this many values per call
+static const int BULK_SIZE = 4096;
+
+// Chi-square buckets, indexed by the top bits of GetUInt()
+static const int BUCKET_BITS = 8;
+static const int NUM_BUCKETS = 1 << BUCKET_BITS;
+
+
+enum EngineType { AVIDA, AVIDA_LANES, SPLITMIX64, XOSHIRO256SS, PCG64, PHILOX, NUM_ENGINE_TYPES };
+
+static const char* ENGINE_NAMES[] = {
+  "AvidaRNG", "AvidaRNGLanes", "SplitMix64", "Xoshiro256StarStar", "PCG64", "Philox"
+};
+
+
+static Apto::Random* CreateEngine(EngineType type, int seed)
+{
+  switch (type) {
+    case AVIDA:         return new Apto::RNG::AvidaRNG(seed);
+    case AVIDA_LANES:   return new Apto::RNG::AvidaRNGLanes(seed);
+    case SPLITMIX64:    return new Apto::RNG::SplitMix64(seed);
+    case XOSHIRO256SS:  return new Apto::RNG::Xoshiro256StarStar(seed);
+    case PCG64:         return new Apto::RNG::PCG64(seed);
+    case PHILOX:        return new Apto::RNG::Philox(seed);
+    default:            return NULL;
+  }
+}
+
+
+// Methods - each times ops calls of one Random method, returning ns per value produced
+// --------------------------------------------------------------------------------------------------------------
+
+static double TimeGetDouble(Apto::Random& rng, int ops)
+{
+  double sum = 0.0;
+  Benchmark::Timer timer;
+  for (int i = 0; i < ops; i++) sum += rng.GetDouble();
+  double ns = timer.NSPerOp(ops);
+  Benchmark::Sink(sum);
+  return ns;
+}
+
+static double TimeGetUInt(Apto::Random& rng, int ops)
+{
+  long long sum = 0;
+  Benchmark::Timer timer;
+  for (int i = 0; i < ops; i++) sum += rng.GetUInt();
+  double ns = timer.NSPerOp(ops);
+  Benchmark::Sink(sum);
+  return ns;
+}
+
+static double TimeGetUIntMax(Apto::Random& rng, int ops)
+{
+  long long sum = 0;
+  Benchmark::Timer timer;
+  for (int i = 0; i < ops; i++) sum += rng.GetUInt(1000);
+  double ns = timer.NSPerOp(ops);
+  Benchmark::Sink(sum);
+  return ns;
+}
+
+static double TimeP(Apto::Random& rng, int ops)
+{
+  long long sum = 0;
+  Benchmark::Timer timer;
+  for (int i = 0; i < ops; i++) sum += rng.P(0.3);
+  double ns = timer.NSPerOp(ops);
+  Benchmark::Sink(sum);
+  return ns;
+}
+
+static double TimeGetRandNormal(Apto::Random& rng, int ops)
+{
+  double sum = 0.0;
+  Benchmark::Timer timer;
+  for (int i = 0; i < ops; i++) sum += rng.GetRandNormal();
+  double ns = timer.NSPerOp(ops);
+  Benchmark::Sink(sum);
+  return ns;
+}
+
+static double TimeGetRandExponential(Apto::Random& rng, int ops)
+{
+  double sum = 0.0;
+  Benchmark::Timer timer;
+  for (int i = 0; i < ops; i++) sum += rng.GetRandExponential();
+  double ns = timer.NSPerOp(ops);
+  Benchmark::Sink(sum);
+  return ns;
+}
+
+static double TimeGetRandPoisson(Apto::Random& rng, int ops)
+{
+  long long sum = 0;
+  Benchmark::Timer timer;
+  for (int i = 0; i < ops; i++) sum += rng.GetRandPoisson(40.0);
+  double ns = timer.NSPerOp(ops);
+  Benchmark::Sink(sum);
+  return ns;
+}
+
+static double TimeGetRandBinomial(Apto::Random& rng, int ops)
+{
+  long long sum = 0;
+  Benchmark::Timer timer;
+  for (int i = 0; i < ops; i++) sum += rng.GetRandBinomial(1000, 0.3);
+  double ns = timer.NSPerOp(ops);
+  Benchmark::Sink(sum);
+  return ns;
+}
+
+static double TimeChoose(Apto::Random& rng, int ops)
+{
+  // Choosing 10 of 1000, reported per call
+  Apto::Array<int> chosen(10);
+  long long sum = 0;
+  const int calls = ops / 10;
+  Benchmark::Timer timer;
+  for (int i = 0; i < calls; i++) {
+    rng.Choose(1000, chosen);
+    sum += chosen[0];
+  }
+  double ns = timer.NSPerOp(calls);
+  Benchmark::Sink(sum);
+  return ns;
+}
+
+static double TimeFillDouble(Apto::Random& rng, int ops)
+{
+  Apto::Array<double> values(BULK_SIZE);
+  const int calls = (ops + BULK_SIZE - 1) / BULK_SIZE;
+  double sum = 0.0;
+  Benchmark::Timer timer;
+  for (int i = 0; i < calls; i++) {
+    rng.FillDouble(&values[0], BULK_SIZE);
+    sum += values[i % BULK_SIZE];
+  }
+  double ns = timer.NSPerOp(static_cast<double>(calls) * BULK_SIZE);
+  Benchmark::Sink(sum);
+  return ns;
+}
+
+static double TimeFillUInt(Apto::Random& rng, int ops)
+{
+  Apto::Array<unsigned int> values(BULK_SIZE);
+  const int calls = (ops + BULK_SIZE - 1) / BULK_SIZE;
+  long long sum = 0;
+  Benchmark::Timer timer;
+  for (int i = 0; i < calls; i++) {
+    rng.FillUInt(&values[0], BULK_SIZE, 1000);
+    sum += values[i % BULK_SIZE];
+  }
+  double ns = timer.NSPerOp(static_cast<double>(calls) * BULK_SIZE);
+  Benchmark::Sink(sum);
+  return ns;
+}
+
+static double TimeFillBernoulli(Apto::Random& rng, int ops)
+{
+  Apto::Array<bool> values(BULK_SIZE);
+  const int calls = (ops + BULK_SIZE - 1) / BULK_SIZE;
+  long long sum = 0;
+  Benchmark::Timer timer;
+  for (int i = 0; i < calls; i++) {
+    rng.FillBernoulli(&values[0], BULK_SIZE, 0.3);
+    sum += values[i % BULK_SIZE];
+  }
+  double ns = timer.NSPerOp(static_cast<double>(calls) * BULK_SIZE);
+  Benchmark::Sink(sum);
+  return ns;
+}
+
+
+struct Method
+{
+  const char* name;
+  double (*time)(Apto::Random& rng, int ops);
+};
+
+static const Method METHODS[] = {
+  { "GetDouble", TimeGetDouble },
+  { "GetUInt", TimeGetUInt },
+  { "GetUInt(1000)", TimeGetUIntMax },
+  { "P(0.3)", TimeP },
+  { "GetRandNormal", TimeGetRandNormal },
+  { "GetRandExponential", TimeGetRandExponential },
+  { "GetRandPoisson(40)", TimeGetRandPoisson },
+  { "GetRandBinomial(1000,.3)", TimeGetRandBinomial },
+  { "Choose(1000,10) per call", TimeChoose },
+  { "FillDouble", TimeFillDouble },
+  { "FillUInt(1000)", TimeFillUInt },
+  { "FillBernoulli(0.3)", TimeFillBernoulli },
+};
+static const int NUM_METHODS = sizeof(METHODS) / sizeof(Method);
+
+
+// CheckQuality - a small statistical battery over raw 32-bit output
+// --------------------------------------------------------------------------------------------------------------
+//
+// Each test is reduced to a z-score under the null hypothesis of independent uniform output:
+//  - chi-square on NUM_BUCKETS equiprobable buckets of the top bits, z = (chi2 - df) / sqrt(2 df)
+//  - lag one serial correlation r of successive GetDouble() values, z = r sqrt(n)
+//  - bit balance, the worst of the 32 per-bit one counts, z = (ones - n / 2) / sqrt(n / 4)
+
+static bool CheckQuality(EngineType type, int draws, double max_z, int seed)
+{
+  Apto::Random* rng = CreateEngine(type, seed);
+  
+  Apto::Array<long long> buckets(NUM_BUCKETS);
+  buckets.SetAll(0);
+  long long ones[32] = { 0 };
+  for (int i = 0; i < draws; i++) {
+    unsigned int value = rng->GetUInt();
+    buckets[value >> (32 - BUCKET_BITS)]++;
+    for (int b = 0; b < 32; b++) ones[b] += (value >> b) & 1;
+  }
+  
+  double sum_xy = 0.0, sum_x = 0.0, sum_x2 = 0.0;
+  double prev = rng->GetDouble();
+  for (int i = 0; i < draws; i++) {
+    double value = rng->GetDouble();
+    sum_xy += prev * value;
+    sum_x += prev;
+    sum_x2 += prev * prev;
+    prev = value;
+  }
+  delete rng;
+  
+  const double expected = static_cast<double>(draws) / NUM_BUCKETS;
+  double chi_square = 0.0;
+  for (int i = 0; i < NUM_BUCKETS; i++) chi_square += (buckets[i] - expected) * (buckets[i] - expected) / expected;
+  const double df = NUM_BUCKETS - 1;
+  const double chi_z = (chi_square - df) / sqrt(2.0 * df);
+  
+  // Successive values share the same marginal moments, so the lag one correlation uses the leading series' moments
+  const double mean = sum_x / draws;
+  const double variance = sum_x2 / draws - mean * mean;
+  const double serial_r = (sum_xy / draws - mean * mean) / variance;
+  const double serial_z = serial_r * sqrt(static_cast<double>(draws));
+  
+  double bit_z = 0.0;
+  int worst_bit = 0;
+  for (int b = 0; b < 32; b++) {
+    double z = fabs(ones[b] - draws / 2.0) / sqrt(draws / 4.0);
+    if (z > bit_z) {
+      bit_z = z;
+      worst_bit = b;
+    }
+  }
+  
+  bool pass = (fabs(chi_z) <= max_z && fabs(serial_z) <= max_z && bit_z <= max_z);
+  printf("%-20s %10d %12.1f %8.2f %10.6f %8.2f %8d %8.2f  %s\n", ENGINE_NAMES[type], draws, chi_square, chi_z,
+         serial_r, serial_z, worst_bit, bit_z, pass ? "ok" : "FAIL");
+  fflush(stdout);
+  
+  return pass;
+}
+
+
+static void Usage(const char* name)
+{
+  fprintf(stderr, "Usage: %s [-ops count] [-draws count] [-maxz z] [-seed seed] [-only engine]\n", name);
+  fprintf(stderr, "  -ops values are timed per method (default %d), -draws feed the quality battery (default %d)\n",
+          DEFAULT_OPS, DEFAULT_QUALITY_DRAWS);
+  fprintf(stderr, "  a quality test fails when its |z| exceeds -maxz (default %g)\n", DEFAULT_MAX_Z);
+}
+
+
+int main(int argc, char* argv[])
+{
+  int ops = DEFAULT_OPS;
+  int draws = DEFAULT_QUALITY_DRAWS;
+  double max_z = DEFAULT_MAX_Z;
+  int seed = 1;
+  int only = -1;
+  
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 < argc && strcmp(argv[i], "-ops") == 0) ops = atoi(argv[++i]);
+    else if (i + 1 < argc && strcmp(argv[i], "-draws") == 0) draws = atoi(argv[++i]);
+    else if (i + 1 < argc && strcmp(argv[i], "-maxz") == 0) max_z = atof(argv[++i]);
+    else if (i + 1 < argc && strcmp(argv[i], "-seed") == 0) seed = atoi(argv[++i]);
+    else if (i + 1 < argc && strcmp(argv[i], "-only") == 0) {
+      const char* name = argv[++i];
+      for (int t = 0; t < NUM_ENGINE_TYPES; t++) if (strcmp(name, ENGINE_NAMES[t]) == 0) only = t;
+      if (only == -1) {
+        Usage(argv[0]);
+        return 1;
+      }
+    } else {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+  if (ops < 10 || draws < NUM_BUCKETS) {
+    Usage(argv[0]);
+    return 1;
+  }
+  
+  // Throughput, one column per engine
+  printf("%-26s", "ns per value");
+  for (int t = 0; t < NUM_ENGINE_TYPES; t++) if (only == -1 || t == only) printf(" %19s", ENGINE_NAMES[t]);
+  printf("\n");
+  for (int m = 0; m < NUM_METHODS; m++) {
+    printf("%-26s", METHODS[m].name);
+    for (int t = 0; t < NUM_ENGINE_TYPES; t++) {
+      if (only != -1 && t != only) continue;
+      Apto::Random* rng = CreateEngine(static_cast<EngineType>(t), seed);
+      printf(" %19.2f", METHODS[m].time(*rng, ops));
+      fflush(stdout);
+      delete rng;
+    }
+    printf("\n");
+  }
+  printf("\n");
+  
+  printf("%-20s %10s %12s %8s %10s %8s %8s %8s\n", "engine", "draws", "chi-square", "z", "serial r", "z",
+         "bit", "z");
+  
+  bool all_pass = true;
+  for (int t = 0; t < NUM_ENGINE_TYPES; t++) {
+    if (only != -1 && t != only) continue;
+    if (!CheckQuality(static_cast<EngineType>(t), draws, max_z, seed)) all_pass = false;
+  }
+  
+  return all_pass ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+/*
+ *  utils/benchmark/Scheduler.cc
+ *  Apto
+ *
+ *  Created by David on 10/19/26.
+ *  Copyright 2026 David Michael Bryson. All rights reserved.
+ *  http://programerror.com/software/apto
+ *
+ *  Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ *  following conditions are met:
+ *
+ *  1.  Redistributions of source code must retain the above copyright notice, this list of conditions and the
+ *      following disclaimer.
+ *  2.  Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *      following disclaimer in the documentation and/or other materials provided with the distribution.
+ *  3.  Neither the name of David Michael Bryson, nor the names of contributors may be used to endorse or promote
+ *      products derived from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY DAVID MICHAEL BRYSON AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *  INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL DAVID MICHAEL BRYSON OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ *  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ *  WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ *  USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  Authors: David M. Bryson <david@programerror.com>
+ *
+ */
+
+#include "Benchmark.h"
+
+#include "apto/core/Array.h"
+#include "apto/rng/AvidaRNG.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+// Default settings, overridable from the command line
+static const int DEFAULT_MAX_POPULATION = 1000000;
+static const int DEFAULT_NEXT_OPS = 1000000;
+static const int DEFAULT_ADJUST_OPS = 100000;
+
+static const int POPULATION_SIZES[] = { 1000, 10000, 100000, 1000000, 10000000 };
+static const int NUM_POPULATION_SIZES = sizeof(POPULATION_SIZES) / sizeof(int);
+
+// Uniform priorities fall in [1, 1000), skewed ones are capped to keep Integrated node counts bounded
+static const double UNIFORM_MAX_PRIORITY = 1000.0;
+static const double SKEWED_MAX_PRIORITY = 1000000.0;
+
+
+static double DrawPriority(Apto::Random& rng, Benchmark::Distribution dist)
+{
+  return Benchmark::DrawPriority(rng, dist, UNIFORM_MAX_PRIORITY, SKEWED_MAX_PRIORITY, false);
+}
+
+
+// RunBenchmark - populate a scheduler, then time Next() throughput and AdjustPriority churn
+// --------------------------------------------------------------------------------------------------------------
+
+static void RunBenchmark(Benchmark::SchedulerType type, Benchmark::Distribution dist, int entry_count, int next_ops,
+                         int adjust_ops)
+{
+  Apto::RNG::AvidaRNG rng(entry_count);
+  
+  // Workloads are generated up front so that random number generation is not part of the timed loops
+  Apto::Array<double> initial(entry_count);
+  for (int i = 0; i < entry_count; i++) initial[i] = DrawPriority(rng, dist);
+  Apto::Array<int> churn_ids(adjust_ops);
+  Apto::Array<double> churn_priorities(adjust_ops);
+  for (int i = 0; i < adjust_ops; i++) {
+    churn_ids[i] = rng.GetInt(entry_count);
+    churn_priorities[i] = DrawPriority(rng, dist);
+  }
+  
+  std::size_t base_bytes = Benchmark::AllocatedBytes();
+  Benchmark::ResetPeakAllocatedBytes();
+  
+  Benchmark::Timer timer;
+  Apto::PriorityScheduler* sched = Benchmark::CreateScheduler(type, entry_count, 1);
+  for (int i = 0; i < entry_count; i++) sched->AdjustPriority(i, initial[i]);
+  double populate_ns = timer.NSPerOp(entry_count);
+  
+  std::size_t live_bytes = Benchmark::AllocatedBytes() - base_bytes;
+  
+  long long checksum = 0;
+  timer.Start();
+  for (int i = 0; i < next_ops; i++) checksum += sched->Next();
+  double next_ns = timer.NSPerOp(next_ops);
+  
+  timer.Start();
+  for (int i = 0; i < adjust_ops; i++) sched->AdjustPriority(churn_ids[i], churn_priorities[i]);
+  double adjust_ns = timer.NSPerOp(adjust_ops);
+  
+  std::size_t peak_bytes = Benchmark::PeakAllocatedBytes() - base_bytes;
+  
+  delete sched;
+  Benchmark::Sink(checksum);
+  
+  printf("%-24s %-8s %9d %12.1f %12.1f %12.1f %12.2f %12.2f\n",
+         Benchmark::SCHEDULER_NAMES[type], Benchmark::DISTRIBUTION_NAMES[dist],
+         entry_count, populate_ns, next_ns, adjust_ns, live_bytes / 1048576.0, peak_bytes / 1048576.0);
+  fflush(stdout);
+}
+
+
+static void Usage(const char* name)
+{
+  fprintf(stderr, "Usage: %s [-max population] [-next ops] [-adjust ops] [-only scheduler]\n", name);
+  fprintf(stderr, "  population sizes run from 1000 up to -max (default %d, at most 10000000)\n", DEFAULT_MAX_POPULATION);
+}
+
+
+int main(int argc, char* argv[])
+{
+  int max_population = DEFAULT_MAX_POPULATION;
+  int next_ops = DEFAULT_NEXT_OPS;
+  int adjust_ops = DEFAULT_ADJUST_OPS;
+  int only = -1;
+  
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 < argc && strcmp(argv[i], "-max") == 0) max_population = atoi(argv[++i]);
+    else if (i + 1 < argc && strcmp(argv[i], "-next") == 0) next_ops = atoi(argv[++i]);
+    else if (i + 1 < argc && strcmp(argv[i], "-adjust") == 0) adjust_ops = atoi(argv[++i]);
+    else if (i + 1 < argc && strcmp(argv[i], "-only") == 0) {
+      const char* name = argv[++i];
+      for (int t = 0; t < Benchmark::NUM_SCHEDULER_TYPES; t++) {
+        if (strcmp(name, Benchmark::SCHEDULER_NAMES[t]) == 0) only = t;
+      }
+      if (only == -1) {
+        Usage(argv[0]);
+        return 1;
+      }
+    } else {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+  
+  printf("%-24s %-8s %9s %12s %12s %12s %12s %12s\n", "scheduler", "dist", "entries",
+         "populate ns", "next ns/op", "adjust ns/op", "live MB", "peak MB");
+  
+  for (int t = 0; t < Benchmark::NUM_SCHEDULER_TYPES; t++) {
+    if (only != -1 && t != only) continue;
+    for (int d = 0; d < Benchmark::NUM_DISTRIBUTIONS; d++) {
+      for (int s = 0; s < NUM_POPULATION_SIZES && POPULATION_SIZES[s] <= max_population; s++) {
+        Benchmark::SchedulerType type = static_cast<Benchmark::SchedulerType>(t);
+        RunBenchmark(type, static_cast<Benchmark::Distribution>(d), POPULATION_SIZES[s], next_ops, adjust_ops);
+      }
+    }
+  }
+  
+  return 0;
+}